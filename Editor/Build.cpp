@@ -1,5 +1,14 @@
+#include <algorithm>
 #include <regex>
+#include <set>
 #include "Build.h"
+#include "MeshBaker.h"
+#include "MeshConverter.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "NameHash.h"
+#include "ScriptRewriter.h"
+#include "SegmentPacker.h"
 #include "Util.h"
 #include "BoxCollider.h"
 #include "SphereCollider.h"
@@ -9,7 +18,8 @@
 
 namespace UltraEd
 {
-    bool Build::WriteSpecFile(const std::vector<Actor *> &actors)
+    bool Build::WriteSpecFile(const std::vector<Actor *> &actors,
+        const std::map<std::string, std::string> &resourceCache)
     {
         std::string specSegments, specIncludes;
         const char *specHeader = "#include <nusys.h>\n\n"
@@ -34,71 +44,61 @@ namespace UltraEd
             "\n\tinclude \"code\"";
         const char *specIncludeEnd = "\nendwave";
 
-        std::vector<std::filesystem::path> resourceCache;
-        int loopCount = 0;
+        std::set<std::string> writtenResources;
         for (const auto &actor : actors)
         {
-            auto newResName = Util::NewResourceName(loopCount++);
-
             if (actor->GetType() != ActorType::Model) continue;
 
             auto model = reinterpret_cast<Model *>(actor);
 
             if (model == nullptr) continue;
 
-            auto modelPath = Project::GetAssetPath(model->GetModelId());
+            const auto meshKey = MeshResourceKey(model);
 
-            if (find(resourceCache.begin(), resourceCache.end(), modelPath) == resourceCache.end())
+            if (writtenResources.find(meshKey) == writtenResources.end())
             {
-                std::string id = Util::UuidToString(actor->GetId());
-                id.insert(0, Project::BuildPath().string().append("\\")).append(".sos");
+                auto path = Project::BuildPath() / Util::UuidToString(actor->GetId()).append(".mesh");
+                if (!WriteMeshFile(path, model)) return false;
 
-                std::string modelName(newResName);
+                std::string modelName(resourceCache.at(meshKey));
                 modelName.append("_M");
 
                 specSegments.append("\nbeginseg\n\tname \"");
                 specSegments.append(modelName);
                 specSegments.append("\"\n\tflags RAW\n\tinclude \"");
-                specSegments.append(id);
+                specSegments.append(path.string());
                 specSegments.append("\"\nendseg\n");
 
                 specIncludes.append("\n\tinclude \"");
                 specIncludes.append(modelName);
                 specIncludes.append("\"");
 
-                resourceCache.push_back(modelPath);
+                writtenResources.insert(meshKey);
             }
 
-            const auto texturePath = model->GetTexture()->GetPath();
+            const auto textureKey = model->GetTexture()->GetPath().string();
 
-            if (!texturePath.empty() && find(resourceCache.begin(), resourceCache.end(), texturePath) == resourceCache.end())
+            if (HasValidTexture(model) && writtenResources.find(textureKey) == writtenResources.end())
             {
-                std::string reason;
-                if (model->GetTexture()->IsValid(reason))
-                {
-                    auto path = Project::BuildPath() / texturePath.filename();
-                    model->GetTexture()->WritePngData(path);
+                // Texels are converted to RGBA5551 or a palette of it now so the engine can DMA them straight
+                // into place.
+                auto path = Project::BuildPath() / model->GetTexture()->GetPath().filename().replace_extension(".tex");
+                if (!model->GetTexture()->WriteTexelData(path)) return false;
 
-                    std::string textureName(newResName);
-                    textureName.append("_T");
+                std::string textureName(resourceCache.at(textureKey));
+                textureName.append("_T");
 
-                    specSegments.append("\nbeginseg\n\tname \"");
-                    specSegments.append(textureName);
-                    specSegments.append("\"\n\tflags RAW\n\tinclude \"");
-                    specSegments.append(path.string().c_str());
-                    specSegments.append("\"\nendseg\n");
+                specSegments.append("\nbeginseg\n\tname \"");
+                specSegments.append(textureName);
+                specSegments.append("\"\n\tflags RAW\n\tinclude \"");
+                specSegments.append(path.string().c_str());
+                specSegments.append("\"\nendseg\n");
 
-                    specIncludes.append("\n\tinclude \"");
-                    specIncludes.append(textureName);
-                    specIncludes.append("\"");
+                specIncludes.append("\n\tinclude \"");
+                specIncludes.append(textureName);
+                specIncludes.append("\"");
 
-                    resourceCache.push_back(texturePath);
-                }
-                else
-                {
-                    Debug::Instance().Error(std::string("Invalid texture for model ")
-                        .append(model->GetName()).append(": ").append(reason));
-                }
+                writtenResources.insert(textureKey);
             }
         }
 
@@ -120,11 +120,17 @@ namespace UltraEd
         return true;
     }
 
-    bool Build::WriteDefinitionsFile()
+    bool Build::WriteDefinitionsFile(const std::vector<Actor *> &actors)
     {
         char buffer[128];
         std::string mode = Settings::GetVideoMode() == VideoMode::NTSC ? "OS_VI_NTSC_LAN1" : "OS_VI_PAL_LAN1";
-        sprintf(buffer, "#define _UER_VIDEO_MODE %s\n", mode.c_str());
+        const auto models = std::count_if(actors.begin(), actors.end(),
+            [](Actor *actor) { return actor->GetType() == ActorType::Model; });
+
+        // Meshes call display lists baked into their segments, so each frame's list only grows with the number
+        // of models drawn and never with their triangles.
+        const int commands = FrameCommands + ActorCommands * (static_cast<int>(models) + InstanceHeadroom);
+        sprintf(buffer, "#define _UER_VIDEO_MODE %s\n#define GFX_GLIST_LEN %i\n", mode.c_str(), commands);
 
         std::string path = GetPathFor("Engine\\definitions.h");
         std::unique_ptr<FILE, decltype(fclose) *> file(fopen(path.c_str(), "w"), fclose);
@@ -134,7 +140,7 @@ namespace UltraEd
     }
 
     bool Build::WriteSegmentsFile(const std::vector<Actor *> &actors,
-        std::map<std::filesystem::path, std::string> *resourceCache)
+        std::map<std::string, std::string> *resourceCache)
     {
         std::string romSegments;
         int loopCount = 0;
@@ -148,9 +154,9 @@ namespace UltraEd
 
             if (model == nullptr) continue;
 
-            auto modelPath = Project::GetAssetPath(model->GetModelId());
+            const auto meshKey = MeshResourceKey(model);
 
-            if (resourceCache->find(modelPath) == resourceCache->end())
+            if (resourceCache->find(meshKey) == resourceCache->end())
             {
                 std::string modelName(newResName);
                 modelName.append("_M");
@@ -162,11 +168,17 @@ namespace UltraEd
                 romSegments.append(modelName);
                 romSegments.append("SegmentRomEnd[];\n");
 
-                (*resourceCache)[modelPath] = newResName;
+                (*resourceCache)[meshKey] = newResName;
             }
 
-            auto texturePath = Project::GetAssetPath(model->GetTexture()->GetId());
-            if (!texturePath.empty() && resourceCache->find(texturePath) == resourceCache->end())
+            std::string reason;
+            const auto texturePath = model->GetTexture()->GetPath();
+            if (!texturePath.empty() && !model->GetTexture()->IsValid(reason))
+            {
+                Debug::Instance().Error(std::string("Invalid texture for model ")
+                    .append(model->GetName()).append(": ").append(reason));
+            }
+            else if (!texturePath.empty() && resourceCache->find(texturePath.string()) == resourceCache->end())
             {
                 std::string textureName(newResName);
                 textureName.append("_T");
@@ -178,7 +190,7 @@ namespace UltraEd
                 romSegments.append(textureName);
                 romSegments.append("SegmentRomEnd[];\n");
 
-                (*resourceCache)[texturePath] = newResName;
+                (*resourceCache)[texturePath.string()] = newResName;
             }
         }
 
@@ -204,7 +216,7 @@ namespace UltraEd
     }
 
     bool Build::WriteActorsFile(const std::vector<Actor *> &actors,
-        const std::map<std::filesystem::path, std::string> &resourceCache)
+        const std::map<std::string, std::string> &resourceCache)
     {
         int actorCount = -1;
         std::string totalActors = std::to_string(actors.size());
@@ -228,26 +240,27 @@ namespace UltraEd
             if (actor->GetType() == ActorType::Model)
             {
                 auto model = reinterpret_cast<Model *>(actor);
-                auto modelPath = Project::GetAssetPath(model->GetModelId());
-                auto texturePath = Project::GetAssetPath(model->GetTexture()->GetId());
+                const auto meshKey = MeshResourceKey(model);
+                const auto textureKey = model->GetTexture()->GetPath().string();
+                const bool textured = HasValidTexture(model);
 
-                if (resourceCache.find(modelPath) != resourceCache.end())
-                    resourceName = resourceCache.at(modelPath);
+                if (resourceCache.find(meshKey) != resourceCache.end())
+                    resourceName = resourceCache.at(meshKey);
 
                 std::string modelName(resourceName);
                 modelName.append("_M");
 
-                if (!texturePath.empty())
+                if (textured)
                     actorInits.append("loadTexturedModel(_");
                 else
                     actorInits.append("loadModel(_");
 
                 actorInits.append(modelName).append("SegmentRomStart, _").append(modelName).append("SegmentRomEnd");
 
-                if (!texturePath.empty())
+                if (textured)
                 {
-                    if (resourceCache.find(texturePath) != resourceCache.end())
-                        resourceName = resourceCache.at(texturePath);
+                    if (resourceCache.find(textureKey) != resourceCache.end())
+                        resourceName = resourceCache.at(textureKey);
 
                     std::string textureName(resourceName);
                     textureName.append("_T");
@@ -258,35 +271,20 @@ namespace UltraEd
                         .append(std::to_string(dimensions[1]));
                 }
 
-                // Add transform data.
+                // Add transform data. Scale is already baked into the mesh vertices.
                 char vectorBuffer[256];
-                D3DXVECTOR3 position = actor->GetPosition(), scale = actor->GetScale(), axis;
+                D3DXVECTOR3 position = actor->GetPosition(), axis;
                 float angle;
                 actor->GetAxisAngle(&axis, &angle);
-                sprintf(vectorBuffer, ", %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %s",
+                const auto lodDistances = model->GetLodDistances();
+                sprintf(vectorBuffer, ", %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %s, %lf, %lf",
                     position.x, position.y, position.z,
                     axis.x, axis.y, axis.z, angle * (180.0 / D3DX_PI),
-                    scale.x, scale.y, scale.z,
                     colliderCenter.x, colliderCenter.y, colliderCenter.z, colliderRadius,
                     colliderExtents.x, colliderExtents.y, colliderExtents.z,
-                    actor->HasCollider() ? actor->GetCollider()->GetName() : "None");
+                    actor->HasCollider() ? actor->GetCollider()->GetName() : "None",
+                    lodDistances[0], lodDistances[1]);
                 actorInits.append(vectorBuffer).append("));\n");
-
-                // Write out mesh data.
-                std::vector<Vertex> vertices = actor->GetVertices();
-                std::string id = Util::UuidToString(actor->GetId());
-                id.insert(0, Project::BuildPath().string().append("\\")).append(".sos");
-                FILE *file = fopen(id.c_str(), "w");
-                if (file == NULL) return false;
-                fprintf(file, "%i\n", static_cast<int>(vertices.size()));
-                for (size_t i = 0; i < vertices.size(); i++)
-                {
-                    Vertex vert = vertices[i];
-                    D3DXCOLOR color(vert.color);
-                    fprintf(file, "%f %f %f %f %f %f %f %f %f\n", vert.position.x, vert.position.y, vert.position.z,
-                        color.r, color.g, color.b, color.a, vert.tu, vert.tv);
-                }
-                fclose(file);
             }
             else if (actor->GetType() == ActorType::Camera)
             {
@@ -317,8 +315,9 @@ namespace UltraEd
         fwrite(actorInits.c_str(), 1, actorInits.size(), file.get());
         fwrite("}", 1, 1, file.get());
 
-        const char *drawStart = "\n\nvoid _UER_Draw(Gfx **display_list) {";
-        std::string drawLoop("\n\tfor (int i = 0; i < vector_size(_UER_Actors); i++) {\n\t\tmodelDraw(vector_get(_UER_Actors, i), display_list);\n\t}\n");
+        const char *drawStart = "\n\nint _UER_Draw(Gfx **display_list, Gfx *display_list_end, renderView *view, "
+            "int buffer) {";
+        std::string drawLoop("\n\treturn drawActors(_UER_Actors, view, display_list, display_list_end, buffer);\n");
 
         fwrite(drawStart, 1, strlen(drawStart), file.get());
         fwrite(drawLoop.c_str(), 1, drawLoop.size(), file.get());
@@ -328,142 +327,248 @@ namespace UltraEd
 
     bool Build::WriteCollisionFile(const std::vector<Actor *> &actors)
     {
-        std::string collideSetStart("void _UER_Collide() {");
-        std::string collisions;
-        int collisionCount = 0;
+        std::string collideSetStart("void _UER_Collisions() {");
+        std::string collideStart("\n}\n\nvoid _UER_Collide() {\n\tcollide_actors(_UER_Actors);\n}");
+        std::string callbacks;
+        const auto prefixes = ScriptPrefixes(actors);
+        int actorCount = -1;
         char countBuffer[10];
 
+        // Pairs are found at runtime between actors with a collide callback, so colliders whose collide
+        // does nothing are left without one and never get tested.
         for (const auto &actor : actors)
         {
-            int subLoop = collisionCount++;
-
-            if (!actor->GetCollider()) continue;
+            actorCount++;
 
-            for (auto subActor = next(actors.begin(), collisionCount); subActor != actors.end(); ++subActor)
-            {
-                subLoop++;
-
-                if (!(*subActor)->GetCollider()) continue;
-
-                std::string actorScript = actor->GetScript();
-                std::string subActorScript = (*subActor)->GetScript();
-
-                // Both actors must define a collide method.
-                if (actorScript.find("collide(") == std::string::npos || subActorScript.find("collide(") == std::string::npos)
-                    continue;
-
-                _itoa(collisionCount - 1, countBuffer, 10);
-                collisions.append("\n\tif(check_collision(vector_get(_UER_Actors, ").append(countBuffer);
-                _itoa(subLoop, countBuffer, 10);
-                collisions.append("), vector_get(_UER_Actors, ").append(countBuffer).append(")))\n\t{\n");
+            if (!actor->GetCollider() || !ScriptRewriter::Defines(actor->GetScript(), "$collide"))
+                continue;
 
-                collisions.append("\t\t").append(Util::NewResourceName(subLoop)).append("collide(");
-                _itoa(collisionCount - 1, countBuffer, 10);
-                collisions.append("vector_get(_UER_Actors, ").append(countBuffer).append("));\n");
-
-                collisions.append("\t\t").append(Util::NewResourceName(collisionCount - 1)).append("collide(");
-                _itoa(subLoop, countBuffer, 10);
-                collisions.append("vector_get(_UER_Actors, ").append(countBuffer).append("));\n");
-
-                collisions.append("\t}\n");
-            }
+            _itoa(actorCount, countBuffer, 10);
+            callbacks.append("\n\tvector_get(_UER_Actors, ").append(countBuffer).append(")->collide = ");
+            callbacks.append(prefixes[actorCount]).append("collide;");
         }
 
         std::string collisionPath = GetPathFor("Engine\\collisions.h");
         std::unique_ptr<FILE, decltype(fclose) *> file(fopen(collisionPath.c_str(), "w"), fclose);
         if (file == NULL) return false;
         fwrite(collideSetStart.c_str(), 1, collideSetStart.size(), file.get());
-        fwrite(collisions.c_str(), 1, collisions.size(), file.get());
-        fwrite("}", 1, 1, file.get());
+        fwrite(callbacks.c_str(), 1, callbacks.size(), file.get());
+        fwrite(collideStart.c_str(), 1, collideStart.size(), file.get());
         return true;
     }
 
     bool Build::WriteScriptsFile(const std::vector<Actor *> &actors)
     {
-        std::string scriptStartStart("void _UER_Start() {");
-        std::string scriptUpdateStart("\n\nvoid _UER_Update() {");
-        std::string inputStart("\n\nvoid _UER_Input(NUContData gamepads[4]) {");
-
+        const auto prefixes = ScriptPrefixes(actors);
+        const auto nameDefines = NameDefines(ActorNameIndices(actors));
+        const char *callbacks[] = { "start", "update", "input" };
+        std::string tables[3];
+        bool dispatched[3] = { false, false, false };
+        std::set<std::string> written;
         std::string scripts;
-        char countBuffer[10];
-        int actorCount = -1;
 
-        for (const auto &actor : actors)
+        for (size_t i = 0; i < actors.size(); i++)
         {
-            std::string actorRef;
-            actorRef.append("vector_get(_UER_Actors, ");
+            auto result = ScriptRewriter::Share(actors[i]->GetScript(), prefixes[i]);
 
-            std::string newResName = Util::NewResourceName(++actorCount);
-            std::string script = actor->GetScript();
-            auto result = Util::ReplaceString(script, "$", newResName);
+            for (int callback = 0; callback < 3; callback++)
+            {
+                // Empty callbacks like the ones in the default script are left out of the tables.
+                const std::string name = std::string(prefixes[i]).append(callbacks[callback]);
+                const bool defined = ScriptRewriter::Defines(actors[i]->GetScript(),
+                    std::string("$").append(callbacks[callback]));
+                tables[callback].append(i > 0 ? ",\n\t" : "\n\t").append(defined ? name : "NULL");
+                dispatched[callback] |= defined;
+            }
 
-            _itoa(actorCount, countBuffer, 10);
-            actorRef.append(countBuffer).append(")->");
-            result = Util::ReplaceString(result, "self->", actorRef);
-            scripts.append(result).append("\n\n");
+            // Actors sharing a script share its functions too so it only has to be written once.
+            if (!written.insert(prefixes[i]).second) continue;
 
-            if (scripts.find(std::string(newResName).append("start(")) != std::string::npos)
+            // Names of scene actors are known now so their lookups become a fixed index.
+            for (const auto &define : nameDefines)
             {
-                scriptStartStart.append("\n\t").append(newResName).append("start();\n");
+                const std::string lookup = std::string("FindActorByName(\"").append(define.first).append("\")");
+                result = Util::ReplaceString(result, lookup,
+                    std::string("vector_get(_UER_Actors, ").append(define.second).append(")"));
             }
 
-            if (scripts.find(std::string(newResName).append("update(")) != std::string::npos)
+            scripts.append(result).append("\n\n");
+        }
+
+        // Scene actors keep their slot so each one's callbacks are looked up by index, and destroyed
+        // ones leave an empty slot behind that gets skipped.
+        const std::string count = std::to_string(actors.size());
+        const char *tableNames[] = { "_UER_StartScripts", "_UER_UpdateScripts", "_UER_InputScripts" };
+        const char *parameters[] = { "(actor *self)", "(actor *self)", "(actor *self, NUContData gamepads[4])" };
+        const char *arguments[] = { "(self)", "(self)", "(self, gamepads)" };
+        const char *functions[] = { "void _UER_Start() {", "void _UER_Update() {",
+            "void _UER_Input(NUContData gamepads[4]) {" };
+
+        for (int callback = 0; callback < 3; callback++)
+        {
+            if (dispatched[callback])
             {
-                scriptUpdateStart.append("\n\t").append(newResName).append("update();\n");
+                scripts.append("static void (*const ").append(tableNames[callback]).append("[])")
+                    .append(parameters[callback]).append(" = {").append(tables[callback]).append("\n};\n\n");
             }
 
-            if (scripts.find(std::string(newResName).append("input(")) != std::string::npos)
+            scripts.append(functions[callback]);
+
+            if (dispatched[callback])
             {
-                inputStart.append("\n\t").append(newResName).append("input(gamepads);\n");
+                scripts.append("\n\tint i;\n\tfor (i = 0; i < ").append(count).append("; i++)\n\t{")
+                    .append("\n\t\tactor *self = ").append(tableNames[callback])
+                    .append("[i] ? vector_get(_UER_Actors, i) : NULL;")
+                    .append("\n\t\tif (self) ").append(tableNames[callback]).append("[i]")
+                    .append(arguments[callback]).append(";\n\t}\n");
             }
+
+            scripts.append(callback < 2 ? "}\n\n" : "}");
         }
 
         std::string scriptsPath = GetPathFor("Engine\\scripts.h");
         std::unique_ptr<FILE, decltype(fclose) *> file(fopen(scriptsPath.c_str(), "w"), fclose);
         if (file == NULL) return false;
         fwrite(scripts.c_str(), 1, scripts.size(), file.get());
-        fwrite(scriptStartStart.c_str(), 1, scriptStartStart.size(), file.get());
-        fwrite("}", 1, 1, file.get());
-        fwrite(scriptUpdateStart.c_str(), 1, scriptUpdateStart.size(), file.get());
-        fwrite("}", 1, 1, file.get());
-        fwrite(inputStart.c_str(), 1, inputStart.size(), file.get());
-        fwrite("}", 1, 1, file.get());
         return true;
     }
 
     bool Build::WriteMappingsFile(const std::vector<Actor *> &actors)
     {
-        std::string mappingsStart("void _UER_Mappings() {");
-        int loopCount = 0;
+        const auto nameIndices = ActorNameIndices(actors);
+        std::vector<std::string> names;
+        std::string defines, seeds, keys, indices;
         char countBuffer[10];
 
-        for (const auto &actor : actors)
+        for (const auto &entry : nameIndices)
+        {
+            names.push_back(entry.first);
+        }
+
+        for (const auto &define : NameDefines(nameIndices))
+        {
+            _itoa(nameIndices.at(define.first), countBuffer, 10);
+            defines.append("#define ").append(define.second).append(" ").append(countBuffer).append("\n");
+        }
+
+        // Scene names go in a collision-free table so lookups hash twice and compare once with no setup at boot.
+        const NameTable table = NameHash::Build(names);
+
+        for (const auto &seed : table.seeds)
         {
-            _itoa(loopCount++, countBuffer, 10);
-            mappingsStart.append("\n\tinsert(\"").append(actor->GetName()).append("\", ")
-                .append(countBuffer).append(");\n");
+            _itoa(seed, countBuffer, 10);
+            seeds.append(seeds.empty() ? "" : ", ").append(countBuffer);
         }
 
+        for (const auto &slot : table.slots)
+        {
+            keys.append(keys.empty() ? "" : ", ");
+            indices.append(indices.empty() ? "" : ", ");
+
+            if (slot < 0)
+            {
+                keys.append("NULL");
+                indices.append("-1");
+                continue;
+            }
+
+            _itoa(nameIndices.at(names[slot]), countBuffer, 10);
+            // Names go into the ROM as C string literals, which quotes and backslashes would break out of.
+            keys.append("\"").append(std::regex_replace(names[slot], std::regex("[\\\\\"]"), "\\$&")).append("\"");
+            indices.append(countBuffer);
+        }
+
+        std::string mappings(defines);
+        _itoa(static_cast<int>(table.seeds.size()), countBuffer, 10);
+        mappings.append("\n#define _UER_NAME_BUCKETS ").append(countBuffer);
+        _itoa(static_cast<int>(table.slots.size()), countBuffer, 10);
+        mappings.append("\n#define _UER_NAME_SLOTS ").append(countBuffer).append("\n\n");
+        mappings.append("static const unsigned short _UER_NameSeeds[_UER_NAME_BUCKETS] = { ").append(seeds)
+            .append(" };\n");
+        mappings.append("static const char *const _UER_NameKeys[_UER_NAME_SLOTS] = { ").append(keys).append(" };\n");
+        mappings.append("static const short _UER_NameActors[_UER_NAME_SLOTS] = { ").append(indices).append(" };\n");
+
         std::string mappingsPath = GetPathFor("Engine\\mappings.h");
         std::unique_ptr<FILE, decltype(fclose) *> file(fopen(mappingsPath.c_str(), "w"), fclose);
         if (file == NULL) return false;
-        fwrite(mappingsStart.c_str(), 1, mappingsStart.size(), file.get());
-        fwrite("}", 1, 1, file.get());
+        fwrite(mappings.c_str(), 1, mappings.size(), file.get());
         return true;
     }
 
+    std::map<std::string, int> Build::ActorNameIndices(const std::vector<Actor *> &actors)
+    {
+        // Later actors win when names repeat, like they did when each name was inserted at boot.
+        std::map<std::string, int> indices;
+        int actorCount = 0;
+
+        for (const auto &actor : actors)
+        {
+            indices[actor->GetName()] = actorCount++;
+        }
+
+        return indices;
+    }
+
+    std::vector<std::string> Build::ScriptPrefixes(const std::vector<Actor *> &actors)
+    {
+        std::vector<std::string> scripts;
+
+        for (const auto &actor : actors)
+        {
+            scripts.push_back(actor->GetScript());
+        }
+
+        return ScriptRewriter::Prefixes(scripts);
+    }
+
+    std::map<std::string, std::string> Build::NameDefines(const std::map<std::string, int> &nameIndices)
+    {
+        std::map<std::string, std::string> defines;
+        std::set<std::string> used;
+        char countBuffer[10];
+
+        for (const auto &entry : nameIndices)
+        {
+            std::string define("_UER_NAME_");
+            for (const auto &character : entry.first)
+            {
+                define.push_back(isalnum(static_cast<unsigned char>(character)) ? character : '_');
+            }
+
+            // Names that only differ by characters C identifiers can't hold are told apart by actor index.
+            if (!used.insert(define).second)
+            {
+                _itoa(entry.second, countBuffer, 10);
+                define.append("_").append(countBuffer);
+                used.insert(define);
+            }
+
+            defines[entry.first] = define;
+        }
+
+        return defines;
+    }
+
     bool Build::Start(Scene *scene)
     {
         auto actors = scene->GetActors();
 
+        // Scene actors that don't fit in the engine's pool would come back NULL while the ROM boots.
+        if (actors.size() > ActorPoolCapacity)
+        {
+            Debug::Instance().Error(std::string("The scene has ").append(std::to_string(actors.size()))
+                .append(" actors but the engine only holds ").append(std::to_string(ActorPoolCapacity)).append("."));
+            return false;
+        }
+
         // Share texture and model data to reduce ROM size. Resource use is tracked during
         // segment generation and the actor script generator uses that info. 
-        std::map<std::filesystem::path, std::string> resourceCache;
+        std::map<std::string, std::string> resourceCache;
         WriteSegmentsFile(actors, &resourceCache);
         WriteActorsFile(actors, resourceCache);
 
-        WriteSpecFile(actors);
-        WriteDefinitionsFile();
+        if (!WriteSpecFile(actors, resourceCache)) return false;
+        WriteDefinitionsFile(actors);
         WriteCollisionFile(actors);
         WriteScriptsFile(actors);
         WriteMappingsFile(actors);
@@ -644,6 +749,105 @@ namespace UltraEd
         return false;
     }
 
+    bool Build::WriteMeshFile(const std::filesystem::path &path, Model *model)
+    {
+        const bool textured = HasValidTexture(model);
+        const auto textureSize = textured ? model->GetTexture()->Dimensions() : std::array<int, 2> { 0, 0 };
+        const auto texture = TextureTiler::Layout(textureSize,
+            textured ? model->GetTexture()->Format() : TexelFormat::Rgba16);
+        auto vertices = MeshConverter::ToN64(model->GetVertices(), model->GetScale(), textureSize);
+        std::vector<std::vector<TileGroup>> lods { TileGroups(vertices, texture) };
+
+        int vertexLoads = 0, batches = 0;
+        for (const auto &group : lods[0])
+        {
+            vertexLoads += MeshOptimizer::VertexLoads(group.mesh);
+            batches += static_cast<int>(group.mesh.batches.size());
+        }
+
+        Debug::Instance().Info(std::string("Mesh for ").append(model->GetName()).append(": ")
+            .append(std::to_string(MeshOptimizer::DeindexedVertexLoads(vertices))).append(" vertex loads reduced to ")
+            .append(std::to_string(vertexLoads)).append(" in ").append(std::to_string(batches)).append(" batches"));
+
+        // Each level of detail halves the triangles of the last, stopping once a mesh is too small to bother.
+        std::string lodTriangles;
+        while (static_cast<int>(lods.size()) < MeshBaker::MaxLods && static_cast<int>(vertices.size() / 3) >= MinLodTriangles * 2)
+        {
+            const auto simplified = MeshSimplifier::Simplify(vertices, static_cast<int>(vertices.size() / 6));
+            if (simplified.size() * 4 > vertices.size() * 3) break;
+
+            vertices = simplified;
+            lods.push_back(TileGroups(vertices, texture));
+            lodTriangles.append(" ").append(std::to_string(vertices.size() / 3));
+        }
+
+        if (!lodTriangles.empty())
+        {
+            Debug::Instance().Info(std::string("Levels of detail for ").append(model->GetName())
+                .append(" with triangles:").append(lodTriangles));
+        }
+
+        if (textured)
+        {
+            std::string loads;
+            for (const auto &lod : lods)
+            {
+                loads.append(" ").append(std::to_string(MeshBaker::TextureLoads(lod, texture)));
+            }
+
+            Debug::Instance().Info(std::string("Texture loads per draw for ").append(model->GetName())
+                .append(texture.IsTiled() ? std::string(" split into ").append(std::to_string(texture.TileCount()))
+                    .append(" tiles:") : std::string(":")).append(loads));
+        }
+
+        // Vertices and the display lists that draw them are stored exactly as the RSP expects them
+        // so the engine only has to patch in addresses after the DMA.
+        RomBuffer buffer;
+        MeshBaker::Bake(buffer, lods, texture);
+
+        const auto packed = SegmentPacker::Pack(buffer);
+        if (SegmentPacker::IsPacked(packed))
+        {
+            Debug::Instance().Info(std::string("Mesh segment for ").append(model->GetName())
+                .append(" compressed from ").append(std::to_string(buffer.Size())).append(" to ")
+                .append(std::to_string(packed.Size() - SegmentPacker::HeaderSize)).append(" bytes"));
+        }
+
+        return packed.WriteFile(path);
+    }
+
+    std::vector<TileGroup> Build::TileGroups(const std::vector<N64Vertex> &vertices, const TextureLayout &texture)
+    {
+        // Textures too large for TMEM are cut into tiles, and the triangles along with them, so each tile's
+        // triangles are optimized and drawn on their own after its load.
+        std::vector<TileGroup> groups;
+        for (const auto &tile : TextureTiler::Split(vertices, texture))
+        {
+            groups.push_back({ tile.first, MeshOptimizer::Optimize(tile.second) });
+        }
+        return groups;
+    }
+
+    std::string Build::MeshResourceKey(Model *model)
+    {
+        // Scale and texture size are baked into the vertices and the display list loads the texture
+        // so they must all be part of the key.
+        char buffer[128];
+        const auto scale = model->GetScale();
+        const bool textured = HasValidTexture(model);
+        const auto textureSize = textured ? model->GetTexture()->Dimensions() : std::array<int, 2> { 0, 0 };
+        sprintf(buffer, "|%f|%f|%f|%i|%i|", scale.x, scale.y, scale.z, textureSize[0], textureSize[1]);
+
+        return Project::GetAssetPath(model->GetModelId()).string().append(buffer)
+            .append(textured ? model->GetTexture()->GetPath().string() : std::string());
+    }
+
+    bool Build::HasValidTexture(Model *model)
+    {
+        std::string reason;
+        return !model->GetTexture()->GetPath().empty() && model->GetTexture()->IsValid(reason);
+    }
+
     std::string Build::GetPathFor(const std::string &name)
     {
         char buffer[MAX_PATH];
@@ -6,6 +6,7 @@
 #include <vector>
 #include "actor.h"
 #include "Scene.h"
+#include "TextureTiler.h"
 
 namespace UltraEd
 {
@@ -17,16 +18,39 @@ namespace UltraEd
         static bool Load();
 
     private:
-        static bool WriteSpecFile(const std::vector<Actor*> &actors);
-        static bool WriteDefinitionsFile();
-        static bool WriteSegmentsFile(const std::vector<Actor*> &actors, std::map<std::filesystem::path, std::string> *resourceCache);
+        static bool WriteSpecFile(const std::vector<Actor*> &actors, const std::map<std::string, std::string> &resourceCache);
+        static bool WriteDefinitionsFile(const std::vector<Actor*> &actors);
+        static bool WriteSegmentsFile(const std::vector<Actor*> &actors, std::map<std::string, std::string> *resourceCache);
         static bool WriteSceneFile(Scene *scene);
-        static bool WriteActorsFile(const std::vector<Actor*> &actors, const std::map<std::filesystem::path, std::string> &resourceCache);
+        static bool WriteActorsFile(const std::vector<Actor*> &actors, const std::map<std::string, std::string> &resourceCache);
         static bool WriteCollisionFile(const std::vector<Actor*> &actors);
         static bool WriteScriptsFile(const std::vector<Actor*> &actors);
         static bool WriteMappingsFile(const std::vector<Actor*> &actors);
+        static bool WriteMeshFile(const std::filesystem::path &path, Model *model);
+        static std::vector<TileGroup> TileGroups(const std::vector<N64Vertex> &vertices, const TextureLayout &texture);
+        static std::map<std::string, int> ActorNameIndices(const std::vector<Actor*> &actors);
+        static std::vector<std::string> ScriptPrefixes(const std::vector<Actor*> &actors);
+        static std::map<std::string, std::string> NameDefines(const std::map<std::string, int> &nameIndices);
+        static std::string MeshResourceKey(Model *model);
+        static bool HasValidTexture(Model *model);
         static bool Compile();
         static std::string GetPathFor(const std::string &name);
+
+    private:
+        // Meshes with fewer triangles than this aren't simplified any further.
+        static const int MinLodTriangles = 64;
+
+        // Display list commands main.c adds each frame around the actors, including the room it keeps at the end.
+        static const int FrameCommands = 15 + 48;
+
+        // Most commands drawActors adds for one model, matching GFX_ACTOR_COMMANDS in render.h.
+        static const int ActorCommands = 5;
+
+        // Most actors alive at once, matching ACTOR_POOL_CAPACITY in pool.h.
+        static const size_t ActorPoolCapacity = 256;
+
+        // Models scripts can instantiate on top of the scene's before the engine starts leaving some out.
+        static const int InstanceHeadroom = 32;
     };
 }
 
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include "GbiEncoder.h"
+
+namespace UltraEd
+{
+    // G_CCMUX_0 and G_ACMUX_0 are masked down to each field's width just like gsDPSetCombineLERP does.
+    const CombineCycle GbiEncoder::CombineShade { 31, 31, 31, 4, 7, 7, 7, 4 };
+    const CombineCycle GbiEncoder::CombineModulateRgb { 1, 31, 4, 31, 7, 7, 7, 4 };
+
+    GbiEncoder::GbiEncoder() : m_commands(), m_relocated()
+    { }
+
+    void GbiEncoder::PipeSync()
+    {
+        Add(0xE7000000, 0);
+    }
+
+    void GbiEncoder::LoadSync()
+    {
+        Add(0xE6000000, 0);
+    }
+
+    void GbiEncoder::TileSync()
+    {
+        Add(0xE8000000, 0);
+    }
+
+    void GbiEncoder::SetOtherModeH(int shift, int length, unsigned int data)
+    {
+        Add(Shift(0xE3, 24, 8) | Shift(32 - shift - length, 8, 8) | Shift(length - 1, 0, 8), data);
+    }
+
+    void GbiEncoder::SetOtherModeL(int shift, int length, unsigned int data)
+    {
+        Add(Shift(0xE2, 24, 8) | Shift(32 - shift - length, 8, 8) | Shift(length - 1, 0, 8), data);
+    }
+
+    void GbiEncoder::SetCycleType(unsigned int type)
+    {
+        SetOtherModeH(20, 2, type);
+    }
+
+    void GbiEncoder::SetRenderMode(unsigned int mode1, unsigned int mode2)
+    {
+        SetOtherModeL(3, 29, mode1 | mode2);
+    }
+
+    void GbiEncoder::SetTextureFilter(unsigned int type)
+    {
+        SetOtherModeH(12, 2, type);
+    }
+
+    void GbiEncoder::SetTexturePersp(unsigned int type)
+    {
+        SetOtherModeH(19, 1, type);
+    }
+
+    void GbiEncoder::SetTextureLut(unsigned int type)
+    {
+        SetOtherModeH(14, 2, type);
+    }
+
+    void GbiEncoder::GeometryMode(unsigned int clear, unsigned int set)
+    {
+        Add(Shift(0xD9, 24, 8) | Shift(~clear, 0, 24), set);
+    }
+
+    void GbiEncoder::SetCombine(const CombineCycle &cycle0, const CombineCycle &cycle1)
+    {
+        const unsigned int w0 = Shift(cycle0.a, 20, 4) | Shift(cycle0.c, 15, 5) | Shift(cycle0.alphaA, 12, 3)
+            | Shift(cycle0.alphaC, 9, 3) | Shift(cycle1.a, 5, 4) | Shift(cycle1.c, 0, 5);
+        const unsigned int w1 = Shift(cycle0.b, 28, 4) | Shift(cycle0.d, 15, 3) | Shift(cycle0.alphaB, 12, 3)
+            | Shift(cycle0.alphaD, 9, 3) | Shift(cycle1.b, 24, 4) | Shift(cycle1.alphaA, 21, 3)
+            | Shift(cycle1.alphaC, 18, 3) | Shift(cycle1.d, 6, 3) | Shift(cycle1.alphaB, 3, 3)
+            | Shift(cycle1.alphaD, 0, 3);
+        Add(Shift(0xFC, 24, 8) | w0, w1);
+    }
+
+    void GbiEncoder::Texture(int s, int t, int level, int tile, bool on)
+    {
+        Add(Shift(0xD7, 24, 8) | Shift(level, 11, 3) | Shift(tile, 8, 3) | Shift(on ? 1 : 0, 1, 7),
+            Shift(s, 16, 16) | Shift(t, 0, 16));
+    }
+
+    void GbiEncoder::SetTextureImage(int format, int size, int width, int segment, unsigned int offset)
+    {
+        AddRelocated(Shift(0xFD, 24, 8) | Shift(format, 21, 3) | Shift(size, 19, 2) | Shift(width - 1, 0, 12),
+            segment, offset);
+    }
+
+    void GbiEncoder::SetTile(int format, int size, int line, int tmem, int tile, int palette, int cmt, int maskt,
+        int shiftt, int cms, int masks, int shifts)
+    {
+        Add(Shift(0xF5, 24, 8) | Shift(format, 21, 3) | Shift(size, 19, 2) | Shift(line, 9, 9) | Shift(tmem, 0, 9),
+            Shift(tile, 24, 3) | Shift(palette, 20, 4) | Shift(cmt, 18, 2) | Shift(maskt, 14, 4)
+            | Shift(shiftt, 10, 4) | Shift(cms, 8, 2) | Shift(masks, 4, 4) | Shift(shifts, 0, 4));
+    }
+
+    void GbiEncoder::LoadBlock(int tile, int uls, int ult, int lrs, int dxt)
+    {
+        Add(Shift(0xF3, 24, 8) | Shift(uls, 12, 12) | Shift(ult, 0, 12),
+            Shift(tile, 24, 3) | Shift(lrs < MaxBlockTexels ? lrs : MaxBlockTexels, 12, 12) | Shift(dxt, 0, 12));
+    }
+
+    void GbiEncoder::SetTileSize(int tile, int uls, int ult, int lrs, int lrt)
+    {
+        Add(Shift(0xF2, 24, 8) | Shift(uls, 12, 12) | Shift(ult, 0, 12),
+            Shift(tile, 24, 3) | Shift(lrs, 12, 12) | Shift(lrt, 0, 12));
+    }
+
+    void GbiEncoder::LoadTlutCommand(int tile, int count)
+    {
+        Add(Shift(0xF0, 24, 8), Shift(tile, 24, 3) | Shift(count, 14, 10));
+    }
+
+    void GbiEncoder::LoadTlut(int segment, unsigned int offset, int colors)
+    {
+        // Same expansion as gDPLoadTLUT_pal16 for palette 0 and gDPLoadTLUT_pal256, which both start the
+        // palette at the upper half of TMEM.
+        SetTextureImage(FormatRgba, Size16b, 1, segment, offset);
+        TileSync();
+        SetTile(0, 0, 0, TlutTmem, LoadTile, 0, 0, 0, 0, 0, 0, 0);
+        LoadSync();
+        LoadTlutCommand(LoadTile, colors - 1);
+        PipeSync();
+    }
+
+    void GbiEncoder::LoadTextureBlock(int segment, unsigned int offset, int format, int size, int width, int height,
+        int palette, int cms, int cmt)
+    {
+        // Same expansion as gDPLoadTextureBlock and its _4b variant: texels are always loaded as 16-bit words.
+        const int texels = size == Size4b ? (width * height + 3) >> 2 : size == Size8b ? (width * height + 1) >> 1
+            : width * height;
+        const int lineBytes = size == Size4b ? width >> 1 : width << (size - 1);
+        const int words = std::max(1, lineBytes / 8);
+        const int dxt = ((1 << 11) + words - 1) / words;
+
+        SetTextureImage(format, Size16b, 1, segment, offset);
+        SetTile(format, Size16b, 0, 0, LoadTile, 0, cmt, 0, 0, cms, 0, 0);
+        LoadSync();
+        LoadBlock(LoadTile, 0, 0, texels - 1, dxt);
+        PipeSync();
+        SetTile(format, size, (lineBytes + 7) >> 3, 0, RenderTile, palette, cmt, 0, 0, cms, 0, 0);
+        SetTileSize(RenderTile, 0, 0, (width - 1) << 2, (height - 1) << 2);
+    }
+
+    void GbiEncoder::Vertex(int segment, unsigned int offset, int count, int v0)
+    {
+        AddRelocated(Shift(0x01, 24, 8) | Shift(count, 12, 8) | Shift(v0 + count, 1, 7), segment, offset);
+    }
+
+    void GbiEncoder::Triangle(int v0, int v1, int v2)
+    {
+        Add(Shift(0x05, 24, 8) | Shift(v0 * 2, 16, 8) | Shift(v1 * 2, 8, 8) | Shift(v2 * 2, 0, 8), 0);
+    }
+
+    void GbiEncoder::Triangles(int v00, int v01, int v02, int v10, int v11, int v12)
+    {
+        Add(Shift(0x06, 24, 8) | Shift(v00 * 2, 16, 8) | Shift(v01 * 2, 8, 8) | Shift(v02 * 2, 0, 8),
+            Shift(v10 * 2, 16, 8) | Shift(v11 * 2, 8, 8) | Shift(v12 * 2, 0, 8));
+    }
+
+    void GbiEncoder::DisplayList(int segment, unsigned int offset)
+    {
+        AddRelocated(Shift(0xDE, 24, 8), segment, offset);
+    }
+
+    void GbiEncoder::EndDisplayList()
+    {
+        Add(0xDF000000, 0);
+    }
+
+    void GbiEncoder::Write(RomBuffer &buffer, std::vector<unsigned int> *relocations) const
+    {
+        const size_t start = buffer.Size();
+
+        for (const auto &command : m_commands)
+        {
+            buffer.Write32(command[0]);
+            buffer.Write32(command[1]);
+        }
+
+        if (relocations == nullptr) return;
+
+        for (const auto &index : m_relocated)
+        {
+            relocations->push_back(static_cast<unsigned int>(start + index * CommandSize + 4));
+        }
+    }
+
+    void GbiEncoder::Add(unsigned int w0, unsigned int w1)
+    {
+        m_commands.push_back({ w0, w1 });
+    }
+
+    void GbiEncoder::AddRelocated(unsigned int w0, int segment, unsigned int offset)
+    {
+        m_relocated.push_back(m_commands.size());
+        Add(w0, Shift(segment, 24, 8) | Shift(offset, 0, 24));
+    }
+
+    unsigned int GbiEncoder::Shift(unsigned int value, int shift, int width)
+    {
+        return (value & ((1u << width) - 1)) << shift;
+    }
+}
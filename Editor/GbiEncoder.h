@@ -0,0 +1,94 @@
+#ifndef _GBIENCODER_H_
+#define _GBIENCODER_H_
+
+#include <array>
+#include <vector>
+#include "RomBuffer.h"
+
+namespace UltraEd
+{
+    // Matches the G_CCMUX and G_ACMUX selectors of one color combiner cycle.
+    struct CombineCycle
+    {
+        int a, b, c, d;
+        int alphaA, alphaB, alphaC, alphaD;
+    };
+
+    // Encodes F3DEX2 display list commands the same way the gbi.h macros do so they can be baked into ROM.
+    class GbiEncoder
+    {
+    public:
+        GbiEncoder();
+        void PipeSync();
+        void LoadSync();
+        void TileSync();
+        void SetOtherModeH(int shift, int length, unsigned int data);
+        void SetOtherModeL(int shift, int length, unsigned int data);
+        void SetCycleType(unsigned int type);
+        void SetRenderMode(unsigned int mode1, unsigned int mode2);
+        void SetTextureFilter(unsigned int type);
+        void SetTexturePersp(unsigned int type);
+        void SetTextureLut(unsigned int type);
+        void GeometryMode(unsigned int clear, unsigned int set);
+        void SetCombine(const CombineCycle &cycle0, const CombineCycle &cycle1);
+        void Texture(int s, int t, int level, int tile, bool on);
+        void SetTextureImage(int format, int size, int width, int segment, unsigned int offset);
+        void SetTile(int format, int size, int line, int tmem, int tile, int palette, int cmt, int maskt, int shiftt,
+            int cms, int masks, int shifts);
+        void LoadBlock(int tile, int uls, int ult, int lrs, int dxt);
+        void SetTileSize(int tile, int uls, int ult, int lrs, int lrt);
+        void LoadTlutCommand(int tile, int count);
+        void LoadTlut(int segment, unsigned int offset, int colors);
+        void LoadTextureBlock(int segment, unsigned int offset, int format, int size, int width, int height,
+            int palette, int cms, int cmt);
+        void Vertex(int segment, unsigned int offset, int count, int v0);
+        void Triangle(int v0, int v1, int v2);
+        void Triangles(int v00, int v01, int v02, int v10, int v11, int v12);
+        void DisplayList(int segment, unsigned int offset);
+        void EndDisplayList();
+        size_t Size() const { return m_commands.size() * CommandSize; }
+        void Write(RomBuffer &buffer, std::vector<unsigned int> *relocations) const;
+
+    public:
+        static const int CommandSize = 8;
+
+        // Commands, modes and formats from gbi.h built with F3DEX_GBI_2.
+        static const unsigned int CycleOne = 0;
+        static const unsigned int FilterBilerp = 0x2000;
+        static const unsigned int PerspCorrect = 0x80000;
+        static const unsigned int TlutNone = 0;
+        static const unsigned int TlutRgba16 = 0x8000;
+        static const unsigned int RenderModeOpaque = 0x00442078;
+        static const unsigned int RenderModeOpaque2 = 0x00112078;
+        static const unsigned int ZBuffer = 0x1;
+        static const unsigned int Shade = 0x4;
+        static const unsigned int CullFront = 0x200;
+        static const unsigned int ShadingSmooth = 0x200000;
+        static const int FormatRgba = 0;
+        static const int FormatCi = 2;
+        static const int Size4b = 0;
+        static const int Size8b = 1;
+        static const int Size16b = 2;
+        static const int LoadTile = 7;
+        static const int RenderTile = 0;
+        static const int Wrap = 0;
+        static const int Clamp = 2;
+        static const int MaxBlockTexels = 2047;
+        static const int TlutTmem = 256;
+        static const CombineCycle CombineShade;
+        static const CombineCycle CombineModulateRgb;
+
+    private:
+        void Add(unsigned int w0, unsigned int w1);
+        void AddRelocated(unsigned int w0, int segment, unsigned int offset);
+        static unsigned int Shift(unsigned int value, int shift, int width);
+
+    private:
+        std::vector<std::array<unsigned int, 2>> m_commands;
+
+        // Indices of commands whose second word holds a segmented address to patch at load.
+        std::vector<size_t> m_relocated;
+    };
+}
+
+#endif
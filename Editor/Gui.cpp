@@ -880,11 +880,19 @@ namespace UltraEd
         D3DXVECTOR3 tempScale = D3DXVECTOR3(scale);
         ImGui::InputFloat3("Scale", scale, "%g");
 
+        float lodDistances[2] { 0 };
+        std::array<float, 2> tempLodDistances { 0 };
+
         if (targetActor->GetType() == ActorType::Model)
         {
             const auto model = reinterpret_cast<Model *>(targetActor);
             auto texture = m_noTexture;
 
+            tempLodDistances = model->GetLodDistances();
+            lodDistances[0] = tempLodDistances[0];
+            lodDistances[1] = tempLodDistances[1];
+            ImGui::InputFloat2("LOD Distances", lodDistances, "%g");
+
             if (model->GetTexture()->IsLoaded())
             {
                 std::string reason;
@@ -958,6 +966,18 @@ namespace UltraEd
                     tempScale.z != scale[2] ? scale[2] : curScale.z
                 ));
             }
+
+            if ((tempLodDistances[0] != lodDistances[0] || tempLodDistances[1] != lodDistances[1])
+                && actors[i]->GetType() == ActorType::Model)
+            {
+                const auto model = reinterpret_cast<Model *>(actors[i]);
+                auto curLodDistances = model->GetLodDistances();
+                m_scene->m_auditor.ChangeActor("LOD Distances Set", actors[i]->GetId(), groupId);
+                model->SetLodDistances({
+                    tempLodDistances[0] != lodDistances[0] ? lodDistances[0] : curLodDistances[0],
+                    tempLodDistances[1] != lodDistances[1] ? lodDistances[1] : curLodDistances[1]
+                });
+            }
         }
     }
 
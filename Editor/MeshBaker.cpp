@@ -0,0 +1,209 @@
+#include <cstring>
+#include "MeshBaker.h"
+#include "SphereCollider.h"
+
+namespace UltraEd
+{
+    void MeshBaker::Bake(RomBuffer &buffer, const std::vector<std::vector<TileGroup>> &lods,
+        const TextureLayout &texture)
+    {
+        // Header holds offsets to the state and texture load display lists, a key identifying the state so
+        // the engine can skip it between meshes that share it, the relocation table, a bounding sphere for
+        // culling, the geometry display list of each level of detail and whether those lists load texture
+        // tiles themselves.
+        const size_t start = buffer.Size();
+        for (int i = 0; i < HeaderSize; i += 4)
+        {
+            buffer.Write32(0);
+        }
+
+        const int lodCount = lods.size() < MaxLods ? static_cast<int>(lods.size()) : MaxLods;
+        std::vector<std::vector<unsigned int>> vertexOffsets(lodCount);
+        for (int i = 0; i < lodCount; i++)
+        {
+            for (const auto &group : lods[i])
+            {
+                vertexOffsets[i].push_back(static_cast<unsigned int>(buffer.Size() - start));
+                for (const auto &vertex : group.mesh.vertices)
+                {
+                    MeshConverter::Write(buffer, vertex);
+                }
+            }
+        }
+
+        std::vector<unsigned int> relocations;
+        const bool textured = texture.size[0] > 0 && texture.size[1] > 0;
+
+        GbiEncoder state;
+        EncodeState(state, texture);
+        const unsigned int stateOffset = WriteDisplayList(buffer, start, state, &relocations);
+        buffer.Patch32(start, stateOffset);
+        buffer.Patch32(start + 8, Hash(&buffer.Data()[start + stateOffset], state.Size()));
+
+        // Tiled RGBA textures have nothing to load up front, every texel load is made by the geometry.
+        if (textured && (!texture.IsTiled() || texture.format != TexelFormat::Rgba16))
+        {
+            GbiEncoder textureLoad;
+            EncodeTextureLoad(textureLoad, texture);
+            buffer.Patch32(start + 4, WriteDisplayList(buffer, start, textureLoad, &relocations));
+        }
+
+        if (lodCount > 0) WriteBounds(buffer, start + 20, lods[0]);
+
+        buffer.Patch32(start + 36, static_cast<unsigned int>(lodCount));
+        for (int i = 0; i < lodCount; i++)
+        {
+            GbiEncoder geometry;
+            EncodeGeometry(geometry, lods[i], vertexOffsets[i], texture);
+            buffer.Patch32(start + 40 + i * 4, WriteDisplayList(buffer, start, geometry, &relocations));
+        }
+
+        buffer.Patch32(start + 52, textured && texture.IsTiled() ? 1 : 0);
+        buffer.Patch32(start + 12, static_cast<unsigned int>(buffer.Size() - start));
+        buffer.Patch32(start + 16, static_cast<unsigned int>(relocations.size()));
+        for (const auto &relocation : relocations)
+        {
+            buffer.Write32(relocation - static_cast<unsigned int>(start));
+        }
+        buffer.Align(8);
+    }
+
+    int MeshBaker::TextureLoads(const std::vector<TileGroup> &lod, const TextureLayout &texture)
+    {
+        if (texture.size[0] == 0 || texture.size[1] == 0) return 0;
+        return texture.IsTiled() ? static_cast<int>(lod.size()) : 1;
+    }
+
+    void MeshBaker::EncodeState(GbiEncoder &encoder, const TextureLayout &texture)
+    {
+        encoder.PipeSync();
+        encoder.SetCycleType(GbiEncoder::CycleOne);
+        encoder.SetRenderMode(GbiEncoder::RenderModeOpaque, GbiEncoder::RenderModeOpaque2);
+        encoder.GeometryMode(0xFFFFFFFF, GbiEncoder::Shade | GbiEncoder::ShadingSmooth | GbiEncoder::ZBuffer
+            | GbiEncoder::CullFront);
+
+        if (texture.size[0] > 0 && texture.size[1] > 0)
+        {
+            encoder.Texture(0xFFFF, 0xFFFF, 0, GbiEncoder::RenderTile, true);
+            encoder.SetTextureFilter(GbiEncoder::FilterBilerp);
+            encoder.SetTexturePersp(GbiEncoder::PerspCorrect);
+            encoder.SetTextureLut(texture.format == TexelFormat::Rgba16 ? GbiEncoder::TlutNone
+                : GbiEncoder::TlutRgba16);
+            encoder.SetCombine(GbiEncoder::CombineModulateRgb, GbiEncoder::CombineModulateRgb);
+        }
+        else
+        {
+            encoder.Texture(0, 0, 0, GbiEncoder::RenderTile, false);
+            encoder.SetTextureLut(GbiEncoder::TlutNone);
+            encoder.SetCombine(GbiEncoder::CombineShade, GbiEncoder::CombineShade);
+        }
+    }
+
+    void MeshBaker::EncodeTextureLoad(GbiEncoder &encoder, const TextureLayout &texture)
+    {
+        // Indexed texture segments start with the palette, which is loaded ahead of the texels that use it
+        // and stays put while the tiles of a tiled texture are loaded under it.
+        const int colors = TextureConverter::PaletteColors(texture.format);
+        if (colors > 0) encoder.LoadTlut(TextureSegment, 0, colors);
+
+        if (!texture.IsTiled()) EncodeTileLoad(encoder, texture, 0, GbiEncoder::Wrap);
+    }
+
+    void MeshBaker::EncodeTileLoad(GbiEncoder &encoder, const TextureLayout &texture, int tile, int clamp)
+    {
+        const int format = texture.format == TexelFormat::Rgba16 ? GbiEncoder::FormatRgba : GbiEncoder::FormatCi;
+        const int size = texture.format == TexelFormat::Ci4 ? GbiEncoder::Size4b
+            : texture.format == TexelFormat::Ci8 ? GbiEncoder::Size8b : GbiEncoder::Size16b;
+
+        encoder.LoadTextureBlock(TextureSegment, TextureTiler::TileOffset(texture, tile), format, size,
+            texture.tileSize[0], texture.tileSize[1], 0, clamp, clamp);
+    }
+
+    void MeshBaker::EncodeGeometry(GbiEncoder &encoder, const std::vector<TileGroup> &lod,
+        const std::vector<unsigned int> &vertexOffsets, const TextureLayout &texture)
+    {
+        for (size_t i = 0; i < lod.size(); i++)
+        {
+            // Tiles are clamped since wrapping would filter in texels from the opposite edge of the tile.
+            if (texture.IsTiled()) EncodeTileLoad(encoder, texture, lod[i].tile, GbiEncoder::Clamp);
+
+            EncodeBatches(encoder, lod[i].mesh, vertexOffsets[i]);
+        }
+    }
+
+    void MeshBaker::EncodeBatches(GbiEncoder &encoder, const IndexedMesh &mesh, unsigned int vertexOffset)
+    {
+        // Each batch fills the vertex buffer once and its triangles index into it two at a time.
+        for (const auto &batch : mesh.batches)
+        {
+            encoder.Vertex(MeshSegment, vertexOffset + batch.vertexStart * MeshConverter::VertexSize,
+                batch.vertexCount, 0);
+
+            const unsigned char *triangle = &mesh.indices[batch.triangleStart * 3];
+            int remaining = batch.triangleCount;
+
+            for (; remaining > 1; remaining -= 2, triangle += 6)
+            {
+                encoder.Triangles(triangle[0], triangle[1], triangle[2], triangle[3], triangle[4], triangle[5]);
+            }
+
+            if (remaining > 0)
+            {
+                encoder.Triangle(triangle[0], triangle[1], triangle[2]);
+            }
+        }
+    }
+
+    unsigned int MeshBaker::WriteDisplayList(RomBuffer &buffer, size_t start, const GbiEncoder &encoder,
+        std::vector<unsigned int> *relocations)
+    {
+        // Display lists are read by the RSP so they must be 8-byte aligned.
+        buffer.Align(8);
+        const unsigned int offset = static_cast<unsigned int>(buffer.Size() - start);
+
+        GbiEncoder terminated(encoder);
+        terminated.EndDisplayList();
+        terminated.Write(buffer, relocations);
+        return offset;
+    }
+
+    void MeshBaker::WriteBounds(RomBuffer &buffer, size_t offset, const std::vector<TileGroup> &lod)
+    {
+        // Fit the sphere to the vertices as they were quantized so it holds exactly what gets drawn.
+        std::vector<Vertex> vertices;
+        for (const auto &group : lod)
+        {
+            for (const auto &n64Vertex : group.mesh.vertices)
+            {
+                Vertex vertex {};
+                vertex.position = D3DXVECTOR3(n64Vertex.ob[0], n64Vertex.ob[1], n64Vertex.ob[2]);
+                vertices.push_back(vertex);
+            }
+        }
+
+        if (vertices.empty()) return;
+
+        SphereCollider sphere(vertices);
+        const D3DXVECTOR3 center = sphere.GetCenter();
+        const float bounds[] = { center.x, center.y, center.z, sphere.GetRadius() + 1.0f };
+
+        for (int i = 0; i < 4; i++)
+        {
+            // The N64 uses IEEE 754 floats so only the byte order differs.
+            unsigned int bits;
+            memcpy(&bits, &bounds[i], sizeof(bits));
+            buffer.Patch32(offset + i * 4, bits);
+        }
+    }
+
+    unsigned int MeshBaker::Hash(const unsigned char *data, size_t size)
+    {
+        // FNV-1a, never zero so the engine can use zero for no state.
+        unsigned int hash = 2166136261u;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash == 0 ? 1 : hash;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef _MESHBAKER_H_
+#define _MESHBAKER_H_
+
+#include "GbiEncoder.h"
+#include "MeshOptimizer.h"
+#include "RomBuffer.h"
+#include "TextureTiler.h"
+
+namespace UltraEd
+{
+    // Writes a mesh segment holding its vertices and the display lists that set up, texture and draw them
+    // with one geometry list per level of detail. Meshes with a tiled texture load each tile in the geometry
+    // list ahead of the triangles that use it.
+    class MeshBaker
+    {
+    public:
+        static void Bake(RomBuffer &buffer, const std::vector<std::vector<TileGroup>> &lods,
+            const TextureLayout &texture);
+        static int TextureLoads(const std::vector<TileGroup> &lod, const TextureLayout &texture);
+
+    public:
+        // Segment numbers stored in the top byte of baked addresses that the engine swaps for RAM addresses.
+        static const int MeshSegment = 1;
+        static const int TextureSegment = 2;
+        static const int HeaderSize = 64;
+        static const int MaxLods = 3;
+
+    private:
+        MeshBaker() {}
+        static void EncodeState(GbiEncoder &encoder, const TextureLayout &texture);
+        static void EncodeTextureLoad(GbiEncoder &encoder, const TextureLayout &texture);
+        static void EncodeTileLoad(GbiEncoder &encoder, const TextureLayout &texture, int tile, int clamp);
+        static void EncodeGeometry(GbiEncoder &encoder, const std::vector<TileGroup> &lod,
+            const std::vector<unsigned int> &vertexOffsets, const TextureLayout &texture);
+        static void EncodeBatches(GbiEncoder &encoder, const IndexedMesh &mesh, unsigned int vertexOffset);
+        static unsigned int WriteDisplayList(RomBuffer &buffer, size_t start, const GbiEncoder &encoder,
+            std::vector<unsigned int> *relocations);
+        static void WriteBounds(RomBuffer &buffer, size_t offset, const std::vector<TileGroup> &lod);
+        static unsigned int Hash(const unsigned char *data, size_t size);
+    };
+}
+
+#endif
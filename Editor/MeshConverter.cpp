@@ -0,0 +1,74 @@
+#include <cmath>
+#include "MeshConverter.h"
+
+namespace UltraEd
+{
+    N64Vertex MeshConverter::ToN64(const Vertex &vertex, const D3DXVECTOR3 &scale, const std::array<int, 2> &textureSize)
+    {
+        // Follows the same math the engine used when it parsed text meshes at boot so the resulting
+        // vertex is identical; engine units are 100x larger and use a flipped z-axis.
+        N64Vertex n64Vertex;
+        n64Vertex.ob[0] = static_cast<short>(Decimal(vertex.position.x) * Decimal(scale.x) * 100);
+        n64Vertex.ob[1] = static_cast<short>(Decimal(vertex.position.y) * Decimal(scale.y) * 100);
+        n64Vertex.ob[2] = static_cast<short>(-Decimal(vertex.position.z) * Decimal(scale.z) * 100);
+        n64Vertex.flag = 0;
+
+        // Texture coordinates are in s10.5 format.
+        n64Vertex.tc[0] = static_cast<short>(static_cast<int>(Decimal(vertex.tu) * textureSize[0]) << 5);
+        n64Vertex.tc[1] = static_cast<short>(static_cast<int>(Decimal(vertex.tv) * textureSize[1]) << 5);
+
+        // Take the color channels straight from the packed ARGB value so no precision is lost.
+        n64Vertex.cn[0] = static_cast<unsigned char>((vertex.color >> 16) & 0xFF);
+        n64Vertex.cn[1] = static_cast<unsigned char>((vertex.color >> 8) & 0xFF);
+        n64Vertex.cn[2] = static_cast<unsigned char>(vertex.color & 0xFF);
+        n64Vertex.cn[3] = static_cast<unsigned char>((vertex.color >> 24) & 0xFF);
+
+        return n64Vertex;
+    }
+
+    std::vector<N64Vertex> MeshConverter::ToN64(const std::vector<Vertex> &vertices, const D3DXVECTOR3 &scale,
+        const std::array<int, 2> &textureSize)
+    {
+        std::vector<N64Vertex> n64Vertices;
+        n64Vertices.reserve(vertices.size());
+
+        for (const auto &vertex : vertices)
+        {
+            n64Vertices.push_back(ToN64(vertex, scale, textureSize));
+        }
+
+        return n64Vertices;
+    }
+
+    double MeshConverter::Decimal(float value)
+    {
+        // The text format printed six decimal places, so a value a hair below a whole engine unit came back as
+        // that unit and truncated to it instead of the one below. Rounding to the nearest millionth does the
+        // same, and dividing the whole number of millionths back down gives the double the text parsed to.
+        return std::round(static_cast<double>(value) * 1e6) / 1e6;
+    }
+
+    void MeshConverter::Write(RomBuffer &buffer, const N64Vertex &vertex)
+    {
+        buffer.Write16(static_cast<unsigned short>(vertex.ob[0]));
+        buffer.Write16(static_cast<unsigned short>(vertex.ob[1]));
+        buffer.Write16(static_cast<unsigned short>(vertex.ob[2]));
+        buffer.Write16(vertex.flag);
+        buffer.Write16(static_cast<unsigned short>(vertex.tc[0]));
+        buffer.Write16(static_cast<unsigned short>(vertex.tc[1]));
+        buffer.Write(vertex.cn, sizeof(vertex.cn));
+    }
+
+    N64Vertex MeshConverter::Read(const unsigned char *data)
+    {
+        N64Vertex vertex;
+        vertex.ob[0] = static_cast<short>(RomBuffer::Read16(data));
+        vertex.ob[1] = static_cast<short>(RomBuffer::Read16(data + 2));
+        vertex.ob[2] = static_cast<short>(RomBuffer::Read16(data + 4));
+        vertex.flag = RomBuffer::Read16(data + 6);
+        vertex.tc[0] = static_cast<short>(RomBuffer::Read16(data + 8));
+        vertex.tc[1] = static_cast<short>(RomBuffer::Read16(data + 10));
+        memcpy(vertex.cn, data + 12, sizeof(vertex.cn));
+        return vertex;
+    }
+}
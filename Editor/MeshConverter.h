@@ -0,0 +1,44 @@
+#ifndef _MESHCONVERTER_H_
+#define _MESHCONVERTER_H_
+
+#include <array>
+#include <cstring>
+#include <vector>
+#include "RomBuffer.h"
+#include "Vertex.h"
+
+namespace UltraEd
+{
+    // Mirrors the layout of the F3DEX Vtx_t structure.
+    struct N64Vertex
+    {
+        short ob[3];
+        unsigned short flag;
+        short tc[2];
+        unsigned char cn[4];
+
+        bool operator==(const N64Vertex &other) const
+        {
+            return memcmp(this, &other, sizeof(N64Vertex)) == 0;
+        }
+    };
+
+    class MeshConverter
+    {
+    public:
+        static N64Vertex ToN64(const Vertex &vertex, const D3DXVECTOR3 &scale, const std::array<int, 2> &textureSize);
+        static std::vector<N64Vertex> ToN64(const std::vector<Vertex> &vertices, const D3DXVECTOR3 &scale,
+            const std::array<int, 2> &textureSize);
+        static void Write(RomBuffer &buffer, const N64Vertex &vertex);
+        static N64Vertex Read(const unsigned char *data);
+
+    public:
+        static const int VertexSize = 16;
+
+    private:
+        MeshConverter() {}
+        static double Decimal(float value);
+    };
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include <map>
+#include <string>
+#include "MeshOptimizer.h"
+
+namespace UltraEd
+{
+    IndexedMesh MeshOptimizer::Optimize(const std::vector<N64Vertex> &vertices, int cacheSize)
+    {
+        std::vector<N64Vertex> uniqueVertices;
+        std::vector<int> indices;
+        Index(vertices, uniqueVertices, indices);
+
+        const int triangleCount = static_cast<int>(indices.size() / 3);
+        std::vector<std::vector<int>> vertexTriangles(uniqueVertices.size());
+        for (int i = 0; i < triangleCount; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                vertexTriangles[indices[i * 3 + j]].push_back(i);
+            }
+        }
+
+        IndexedMesh mesh;
+        std::vector<bool> emitted(triangleCount, false);
+        int nextSeed = 0;
+
+        while (true)
+        {
+            while (nextSeed < triangleCount && emitted[nextSeed]) nextSeed++;
+            if (nextSeed >= triangleCount) break;
+
+            // Map of unique vertex to its slot in the vertex buffer for this batch.
+            std::map<int, int> slots;
+            MeshBatch batch { static_cast<int>(mesh.vertices.size()), 0,
+                static_cast<int>(mesh.indices.size() / 3), 0 };
+            int triangle = nextSeed;
+
+            while (triangle != -1)
+            {
+                emitted[triangle] = true;
+                batch.triangleCount++;
+
+                for (int j = 0; j < 3; j++)
+                {
+                    const int vertex = indices[triangle * 3 + j];
+                    if (slots.find(vertex) == slots.end())
+                    {
+                        slots[vertex] = batch.vertexCount++;
+                        mesh.vertices.push_back(uniqueVertices[vertex]);
+                    }
+                    mesh.indices.push_back(static_cast<unsigned char>(slots[vertex]));
+                }
+
+                // Grow the batch with the neighbouring triangle that needs the fewest new vertices
+                // so shared vertices are transformed once instead of once per triangle.
+                triangle = -1;
+                int bestCost = 4;
+                for (const auto &slot : slots)
+                {
+                    for (const auto &candidate : vertexTriangles[slot.first])
+                    {
+                        if (emitted[candidate]) continue;
+
+                        int cost = 0;
+                        for (int j = 0; j < 3; j++)
+                        {
+                            if (slots.find(indices[candidate * 3 + j]) == slots.end()) cost++;
+                        }
+
+                        if (batch.vertexCount + cost <= cacheSize &&
+                            (cost < bestCost || (cost == bestCost && candidate < triangle)))
+                        {
+                            bestCost = cost;
+                            triangle = candidate;
+                        }
+                    }
+                }
+
+                // Nothing connected fits so fill the rest of the buffer with the next unused triangle.
+                while (triangle == -1 && nextSeed < triangleCount)
+                {
+                    if (emitted[nextSeed])
+                    {
+                        nextSeed++;
+                        continue;
+                    }
+
+                    int cost = 0;
+                    for (int j = 0; j < 3; j++)
+                    {
+                        if (slots.find(indices[nextSeed * 3 + j]) == slots.end()) cost++;
+                    }
+
+                    if (batch.vertexCount + cost > cacheSize) break;
+                    triangle = nextSeed;
+                }
+            }
+
+            mesh.batches.push_back(batch);
+        }
+
+        return mesh;
+    }
+
+    int MeshOptimizer::VertexLoads(const IndexedMesh &mesh)
+    {
+        int loads = 0;
+        for (const auto &batch : mesh.batches)
+        {
+            loads += batch.vertexCount;
+        }
+        return loads;
+    }
+
+    int MeshOptimizer::DeindexedVertexLoads(const std::vector<N64Vertex> &vertices)
+    {
+        // Every triangle corner was its own vertex and loaded exactly once.
+        return static_cast<int>(vertices.size());
+    }
+
+    void MeshOptimizer::Index(const std::vector<N64Vertex> &vertices, std::vector<N64Vertex> &uniqueVertices,
+        std::vector<int> &indices)
+    {
+        std::map<std::string, int> lookup;
+
+        for (const auto &vertex : vertices)
+        {
+            const std::string key(reinterpret_cast<const char *>(&vertex), sizeof(N64Vertex));
+            const auto match = lookup.find(key);
+
+            if (match == lookup.end())
+            {
+                lookup[key] = static_cast<int>(uniqueVertices.size());
+                indices.push_back(static_cast<int>(uniqueVertices.size()));
+                uniqueVertices.push_back(vertex);
+            }
+            else
+            {
+                indices.push_back(match->second);
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef _MESHOPTIMIZER_H_
+#define _MESHOPTIMIZER_H_
+
+#include <vector>
+#include "MeshConverter.h"
+
+namespace UltraEd
+{
+    // Vertices loaded with a single gSPVertex and the triangles that index into them.
+    struct MeshBatch
+    {
+        int vertexStart;
+        int vertexCount;
+        int triangleStart;
+        int triangleCount;
+    };
+
+    struct IndexedMesh
+    {
+        std::vector<N64Vertex> vertices;
+        std::vector<unsigned char> indices;
+        std::vector<MeshBatch> batches;
+    };
+
+    class MeshOptimizer
+    {
+    public:
+        static IndexedMesh Optimize(const std::vector<N64Vertex> &vertices, int cacheSize = VertexCacheSize);
+        static int VertexLoads(const IndexedMesh &mesh);
+        static int DeindexedVertexLoads(const std::vector<N64Vertex> &vertices);
+
+    public:
+        // Size of the F3DEX2 vertex buffer.
+        static const int VertexCacheSize = 32;
+
+    private:
+        MeshOptimizer() {}
+        static void Index(const std::vector<N64Vertex> &vertices, std::vector<N64Vertex> &uniqueVertices,
+            std::vector<int> &indices);
+    };
+}
+
+#endif
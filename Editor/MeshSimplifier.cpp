@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include "MeshSimplifier.h"
+
+namespace UltraEd
+{
+    std::vector<N64Vertex> MeshSimplifier::Simplify(const std::vector<N64Vertex> &vertices, int targetTriangles)
+    {
+        // Triangle corners keep their own color and texture coordinates, collapses only move positions.
+        std::map<std::array<short, 3>, int> positionLookup;
+        std::vector<std::array<double, 3>> positions;
+        std::vector<std::array<int, 3>> triangles;
+        std::vector<std::array<N64Vertex, 3>> corners;
+
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        {
+            std::array<int, 3> triangle;
+            for (int j = 0; j < 3; j++)
+            {
+                const auto &vertex = vertices[i + j];
+                const std::array<short, 3> key { vertex.ob[0], vertex.ob[1], vertex.ob[2] };
+                const auto match = positionLookup.find(key);
+
+                if (match == positionLookup.end())
+                {
+                    triangle[j] = positionLookup[key] = static_cast<int>(positions.size());
+                    positions.push_back({ static_cast<double>(key[0]), static_cast<double>(key[1]),
+                        static_cast<double>(key[2]) });
+                }
+                else
+                {
+                    triangle[j] = match->second;
+                }
+            }
+
+            if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) continue;
+
+            triangles.push_back(triangle);
+            corners.push_back({ vertices[i], vertices[i + 1], vertices[i + 2] });
+        }
+
+        std::vector<Quadric> quadrics(positions.size(), Quadric {});
+        std::vector<std::vector<int>> positionTriangles(positions.size());
+        std::map<std::pair<int, int>, std::vector<int>> edges;
+
+        for (int i = 0; i < static_cast<int>(triangles.size()); i++)
+        {
+            const auto &triangle = triangles[i];
+            const auto normal = Normal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+            const double area = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (int j = 0; j < 3; j++)
+            {
+                positionTriangles[triangle[j]].push_back(i);
+                edges[std::minmax(triangle[j], triangle[(j + 1) % 3])].push_back(i);
+            }
+
+            if (area == 0) continue;
+
+            // Planes are weighted by area so large faces resist being changed more than slivers.
+            const double a = normal[0] / area, b = normal[1] / area, c = normal[2] / area;
+            const double d = -(a * positions[triangle[0]][0] + b * positions[triangle[0]][1] + c * positions[triangle[0]][2]);
+            const Quadric plane = PlaneQuadric(a, b, c, d, area * 0.5);
+
+            for (int j = 0; j < 3; j++)
+            {
+                Add(quadrics[triangle[j]], plane);
+            }
+        }
+
+        // Edges used by a single triangle are borders, so add a steep plane through them to keep the silhouette.
+        for (const auto &edge : edges)
+        {
+            if (edge.second.size() != 1) continue;
+
+            const auto &triangle = triangles[edge.second[0]];
+            const auto &p0 = positions[edge.first.first];
+            const auto &p1 = positions[edge.first.second];
+            const auto normal = Normal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+            const std::array<double, 3> direction { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const std::array<double, 3> border {
+                direction[1] * normal[2] - direction[2] * normal[1],
+                direction[2] * normal[0] - direction[0] * normal[2],
+                direction[0] * normal[1] - direction[1] * normal[0]
+            };
+            const double length = sqrt(border[0] * border[0] + border[1] * border[1] + border[2] * border[2]);
+
+            if (length == 0) continue;
+
+            const double a = border[0] / length, b = border[1] / length, c = border[2] / length;
+            const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+            const double edgeLength = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+            const Quadric plane = PlaneQuadric(a, b, c, d, edgeLength * 10);
+
+            Add(quadrics[edge.first.first], plane);
+            Add(quadrics[edge.first.second], plane);
+        }
+
+        // Candidate collapses ordered by error. Stamps detect entries made stale by later collapses.
+        struct Collapse
+        {
+            double error;
+            int keep, remove;
+            int keepStamp, removeStamp;
+            bool operator<(const Collapse &other) const { return error > other.error; }
+        };
+
+        std::priority_queue<Collapse> collapses;
+        std::vector<int> stamps(positions.size(), 0);
+        std::vector<bool> removedPositions(positions.size(), false);
+        std::vector<bool> removedTriangles(triangles.size(), false);
+        int triangleCount = static_cast<int>(triangles.size());
+
+        auto queueCollapse = [&](int first, int second) {
+            Quadric combined = quadrics[first];
+            Add(combined, quadrics[second]);
+            const double firstError = Error(combined, positions[first]);
+            const double secondError = Error(combined, positions[second]);
+
+            if (firstError <= secondError)
+                collapses.push({ firstError, first, second, stamps[first], stamps[second] });
+            else
+                collapses.push({ secondError, second, first, stamps[second], stamps[first] });
+        };
+
+        for (const auto &edge : edges)
+        {
+            queueCollapse(edge.first.first, edge.first.second);
+        }
+
+        while (triangleCount > targetTriangles && !collapses.empty())
+        {
+            const Collapse collapse = collapses.top();
+            collapses.pop();
+
+            if (removedPositions[collapse.keep] || removedPositions[collapse.remove]) continue;
+            if (stamps[collapse.keep] != collapse.keepStamp || stamps[collapse.remove] != collapse.removeStamp) continue;
+
+            // Reject collapses that would fold a surviving triangle over onto its back.
+            bool flips = false;
+            for (const auto &index : positionTriangles[collapse.remove])
+            {
+                const auto &triangle = triangles[index];
+                if (removedTriangles[index] || std::find(triangle.begin(), triangle.end(), collapse.keep) != triangle.end())
+                    continue;
+
+                std::array<std::array<double, 3>, 3> moved;
+                for (int j = 0; j < 3; j++)
+                {
+                    moved[j] = positions[triangle[j] == collapse.remove ? collapse.keep : triangle[j]];
+                }
+
+                const auto before = Normal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+                const auto after = Normal(moved[0], moved[1], moved[2]);
+                if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0)
+                {
+                    flips = true;
+                    break;
+                }
+            }
+
+            if (flips) continue;
+
+            for (const auto &index : positionTriangles[collapse.remove])
+            {
+                auto &triangle = triangles[index];
+                if (removedTriangles[index]) continue;
+
+                if (std::find(triangle.begin(), triangle.end(), collapse.keep) != triangle.end())
+                {
+                    removedTriangles[index] = true;
+                    triangleCount--;
+                    continue;
+                }
+
+                for (int j = 0; j < 3; j++)
+                {
+                    if (triangle[j] != collapse.remove) continue;
+
+                    triangle[j] = collapse.keep;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        corners[index][j].ob[k] = static_cast<short>(positions[collapse.keep][k]);
+                    }
+                }
+
+                positionTriangles[collapse.keep].push_back(index);
+            }
+
+            removedPositions[collapse.remove] = true;
+            Add(quadrics[collapse.keep], quadrics[collapse.remove]);
+            stamps[collapse.keep]++;
+
+            // Every edge leaving the kept position now has a different error.
+            for (const auto &index : positionTriangles[collapse.keep])
+            {
+                if (removedTriangles[index]) continue;
+
+                for (const auto &neighbour : triangles[index])
+                {
+                    if (neighbour != collapse.keep) queueCollapse(collapse.keep, neighbour);
+                }
+            }
+        }
+
+        std::vector<N64Vertex> simplified;
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            if (removedTriangles[i]) continue;
+            simplified.insert(simplified.end(), corners[i].begin(), corners[i].end());
+        }
+
+        return simplified;
+    }
+
+    MeshSimplifier::Quadric MeshSimplifier::PlaneQuadric(double a, double b, double c, double d, double weight)
+    {
+        return {
+            a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+            b * b * weight, b * c * weight, b * d * weight,
+            c * c * weight, c * d * weight,
+            d * d * weight
+        };
+    }
+
+    void MeshSimplifier::Add(Quadric &target, const Quadric &other)
+    {
+        for (size_t i = 0; i < target.size(); i++)
+        {
+            target[i] += other[i];
+        }
+    }
+
+    double MeshSimplifier::Error(const Quadric &q, const std::array<double, 3> &p)
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+            + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+            + q[7] * z * z + 2 * q[8] * z
+            + q[9];
+    }
+
+    std::array<double, 3> MeshSimplifier::Normal(const std::array<double, 3> &p0, const std::array<double, 3> &p1,
+        const std::array<double, 3> &p2)
+    {
+        const double ux = p1[0] - p0[0], uy = p1[1] - p0[1], uz = p1[2] - p0[2];
+        const double vx = p2[0] - p0[0], vy = p2[1] - p0[1], vz = p2[2] - p0[2];
+        return { uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx };
+    }
+}
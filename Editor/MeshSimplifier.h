@@ -0,0 +1,29 @@
+#ifndef _MESHSIMPLIFIER_H_
+#define _MESHSIMPLIFIER_H_
+
+#include <array>
+#include <vector>
+#include "MeshConverter.h"
+
+namespace UltraEd
+{
+    // Reduces triangle lists for distant levels of detail using quadric error edge collapses.
+    class MeshSimplifier
+    {
+    public:
+        static std::vector<N64Vertex> Simplify(const std::vector<N64Vertex> &vertices, int targetTriangles);
+
+    private:
+        // Symmetric 4x4 error matrix stored as its upper triangle.
+        typedef std::array<double, 10> Quadric;
+
+        MeshSimplifier() {}
+        static Quadric PlaneQuadric(double a, double b, double c, double d, double weight);
+        static void Add(Quadric &target, const Quadric &other);
+        static double Error(const Quadric &quadric, const std::array<double, 3> &position);
+        static std::array<double, 3> Normal(const std::array<double, 3> &p0, const std::array<double, 3> &p1,
+            const std::array<double, 3> &p2);
+    };
+}
+
+#endif
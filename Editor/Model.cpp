@@ -5,7 +5,8 @@ namespace UltraEd
 {
     Model::Model() :
         m_texture(std::make_shared<Texture>()),
-        m_modelId()
+        m_modelId(),
+        m_lodDistances({ 30, 60 })
     { }
 
     Model::Model(const Model &model) : Model()
@@ -73,7 +74,8 @@ namespace UltraEd
         auto actor = Actor::Save();
         actor.update({
             { "texture_id", m_texture->GetId() },
-            { "model_id", m_modelId }
+            { "model_id", m_modelId },
+            { "lod_distances", m_lodDistances }
         });
         return actor;
     }
@@ -84,5 +86,8 @@ namespace UltraEd
 
         SetMesh(root["model_id"]);
         m_texture->Load(device, root["texture_id"]);
+
+        if (root.contains("lod_distances"))
+            m_lodDistances = root["lod_distances"];
     }
 }
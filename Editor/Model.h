@@ -1,6 +1,7 @@
 #ifndef _MODEL_H_
 #define _MODEL_H_
 
+#include <array>
 #include <filesystem>
 #include "Actor.h"
 #include "Texture.h"
@@ -20,11 +21,16 @@ namespace UltraEd
         const boost::uuids::uuid &GetModelId() { return m_modelId; }
         bool SetTexture(IDirect3DDevice9 *device, const boost::uuids::uuid &assetId);
         void SetMesh(const boost::uuids::uuid &assetId);
+        const std::array<float, 2> &GetLodDistances() { return m_lodDistances; }
+        bool SetLodDistances(const std::array<float, 2> &distances) { return Dirty([&] { m_lodDistances = distances; }, &m_lodDistances); }
         void Render(IDirect3DDevice9 *device, ID3DXMatrixStack *stack);
 
     private:
         std::shared_ptr<Texture> m_texture;
         boost::uuids::uuid m_modelId;
+
+        // Camera distances at which the engine switches to each simplified level of detail.
+        std::array<float, 2> m_lodDistances;
     };
 }
 
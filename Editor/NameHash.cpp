@@ -0,0 +1,96 @@
+#include <algorithm>
+#include "NameHash.h"
+
+namespace UltraEd
+{
+    NameTable NameHash::Build(const std::vector<std::string> &names)
+    {
+        const int count = static_cast<int>(names.size());
+        const int bucketCount = std::max(1, (count + 3) / 4);
+        int slotCount = std::max(1, count + count / 4);
+        NameTable table;
+
+        // Only fails when every seed of some bucket collides, which spare slots make less likely.
+        while (!TryBuild(names, bucketCount, slotCount, &table))
+        {
+            slotCount += std::max(1, slotCount / 4);
+        }
+
+        return table;
+    }
+
+    int NameHash::Find(const NameTable &table, const std::vector<std::string> &names, const std::string &name)
+    {
+        const unsigned int bucket = Hash(name, 0) % table.seeds.size();
+        const int index = table.slots[Hash(name, table.seeds[bucket]) % table.slots.size()];
+        return index >= 0 && names[index] == name ? index : -1;
+    }
+
+    unsigned int NameHash::Hash(const std::string &name, unsigned int seed)
+    {
+        // FNV-1a started from the seed, the engine computes the same thing in name_hash.
+        unsigned int hash = 2166136261u ^ seed;
+        for (const auto &character : name)
+        {
+            hash = (hash ^ static_cast<unsigned char>(character)) * 16777619u;
+        }
+        return hash;
+    }
+
+    bool NameHash::TryBuild(const std::vector<std::string> &names, int bucketCount, int slotCount,
+        NameTable *table)
+    {
+        std::vector<std::vector<int>> buckets(bucketCount);
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            buckets[Hash(names[i], 0) % bucketCount].push_back(static_cast<int>(i));
+        }
+
+        std::vector<int> order(bucketCount);
+        for (int i = 0; i < bucketCount; i++) order[i] = i;
+
+        // Place the fullest buckets while the table is still mostly empty.
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        table->seeds.assign(bucketCount, 0);
+        table->slots.assign(slotCount, -1);
+
+        for (const auto &bucket : order)
+        {
+            if (buckets[bucket].empty()) break;
+
+            bool placed = false;
+            std::vector<int> slots;
+
+            for (unsigned int seed = 1; seed <= MaxSeed && !placed; seed++)
+            {
+                slots.clear();
+                placed = true;
+
+                for (const auto &name : buckets[bucket])
+                {
+                    const int slot = static_cast<int>(Hash(names[name], seed) % slotCount);
+                    if (table->slots[slot] >= 0 || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                    {
+                        placed = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+
+                if (placed) table->seeds[bucket] = seed;
+            }
+
+            if (!placed) return false;
+
+            for (size_t i = 0; i < slots.size(); i++)
+            {
+                table->slots[slots[i]] = buckets[bucket][i];
+            }
+        }
+
+        return true;
+    }
+}
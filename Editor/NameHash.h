@@ -0,0 +1,38 @@
+#ifndef _NAMEHASH_H_
+#define _NAMEHASH_H_
+
+#include <string>
+#include <vector>
+
+namespace UltraEd
+{
+    // Slots for a fixed set of names where every name lands in its own slot. A name's first hash picks a
+    // bucket and the seed stored for that bucket gives the second hash, which picks the slot.
+    struct NameTable
+    {
+        std::vector<unsigned int> seeds;
+
+        // Index of the name held in each slot or -1 when empty.
+        std::vector<int> slots;
+    };
+
+    // Builds collision-free name tables at build time so the engine can find names without probing.
+    class NameHash
+    {
+    public:
+        static NameTable Build(const std::vector<std::string> &names);
+        static int Find(const NameTable &table, const std::vector<std::string> &names, const std::string &name);
+        static unsigned int Hash(const std::string &name, unsigned int seed);
+
+    public:
+        // Seeds are stored as 16-bit values in ROM.
+        static const unsigned int MaxSeed = 0xFFFF;
+
+    private:
+        NameHash() {}
+        static bool TryBuild(const std::vector<std::string> &names, int bucketCount, int slotCount,
+            NameTable *table);
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <memory>
+#include "RomBuffer.h"
+
+namespace UltraEd
+{
+    RomBuffer::RomBuffer() : m_data()
+    { }
+
+    void RomBuffer::Write8(unsigned char value)
+    {
+        m_data.push_back(value);
+    }
+
+    void RomBuffer::Write16(unsigned short value)
+    {
+        m_data.push_back(static_cast<unsigned char>(value >> 8));
+        m_data.push_back(static_cast<unsigned char>(value));
+    }
+
+    void RomBuffer::Write32(unsigned int value)
+    {
+        Write16(static_cast<unsigned short>(value >> 16));
+        Write16(static_cast<unsigned short>(value));
+    }
+
+    void RomBuffer::Write(const unsigned char *data, size_t size)
+    {
+        m_data.insert(m_data.end(), data, data + size);
+    }
+
+    void RomBuffer::Align(size_t alignment)
+    {
+        while (m_data.size() % alignment != 0)
+        {
+            m_data.push_back(0);
+        }
+    }
+
+    void RomBuffer::Patch32(size_t offset, unsigned int value)
+    {
+        if (offset + 4 > m_data.size()) return;
+
+        m_data[offset] = static_cast<unsigned char>(value >> 24);
+        m_data[offset + 1] = static_cast<unsigned char>(value >> 16);
+        m_data[offset + 2] = static_cast<unsigned char>(value >> 8);
+        m_data[offset + 3] = static_cast<unsigned char>(value);
+    }
+
+    bool RomBuffer::WriteFile(const std::filesystem::path &path) const
+    {
+        std::unique_ptr<FILE, decltype(fclose) *> file(fopen(path.string().c_str(), "wb"), fclose);
+        if (file == NULL) return false;
+
+        // PI transfers must be an even number of bytes so pad odd sized segments.
+        size_t bytesWritten = fwrite(m_data.data(), 1, m_data.size(), file.get());
+        if (m_data.size() % 2 != 0) fputc(0, file.get());
+
+        return bytesWritten == m_data.size();
+    }
+
+    unsigned short RomBuffer::Read16(const unsigned char *data)
+    {
+        return static_cast<unsigned short>((data[0] << 8) | data[1]);
+    }
+
+    unsigned int RomBuffer::Read32(const unsigned char *data)
+    {
+        return (static_cast<unsigned int>(Read16(data)) << 16) | Read16(data + 2);
+    }
+}
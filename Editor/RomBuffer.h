@@ -0,0 +1,31 @@
+#ifndef _ROMBUFFER_H_
+#define _ROMBUFFER_H_
+
+#include <filesystem>
+#include <vector>
+
+namespace UltraEd
+{
+    // Byte buffer for data that is read by the N64 as-is, so everything is stored big-endian.
+    class RomBuffer
+    {
+    public:
+        RomBuffer();
+        void Write8(unsigned char value);
+        void Write16(unsigned short value);
+        void Write32(unsigned int value);
+        void Write(const unsigned char *data, size_t size);
+        void Align(size_t alignment);
+        void Patch32(size_t offset, unsigned int value);
+        size_t Size() const { return m_data.size(); }
+        const std::vector<unsigned char> &Data() const { return m_data; }
+        bool WriteFile(const std::filesystem::path &path) const;
+        static unsigned short Read16(const unsigned char *data);
+        static unsigned int Read32(const unsigned char *data);
+
+    private:
+        std::vector<unsigned char> m_data;
+    };
+}
+
+#endif
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include "ScriptRewriter.h"
+#include "Util.h"
+
+namespace UltraEd
+{
+    std::string ScriptRewriter::Normalize(const std::string &script)
+    {
+        std::string normalized;
+        size_t lineStart = 0;
+
+        while (lineStart <= script.size())
+        {
+            size_t lineEnd = script.find('\n', lineStart);
+            if (lineEnd == std::string::npos) lineEnd = script.size();
+
+            size_t end = lineEnd;
+            while (end > lineStart && isspace(static_cast<unsigned char>(script[end - 1]))) end--;
+            normalized.append(script, lineStart, end - lineStart).append("\n");
+
+            lineStart = lineEnd + 1;
+        }
+
+        while (!normalized.empty() && normalized.back() == '\n') normalized.pop_back();
+        return normalized;
+    }
+
+    std::string ScriptRewriter::Share(const std::string &script, const std::string &prefix)
+    {
+        const std::string code = Mask(script);
+        const auto passing = SelfFunctions(code);
+        std::string shared;
+        size_t position = 0;
+
+        while (position < script.size())
+        {
+            // Names are read from the masked copy so nothing in a comment or string counts as a call.
+            const bool nameStart = (code[position] == '$' || IsIdentifier(code[position]))
+                && !isdigit(static_cast<unsigned char>(code[position]))
+                && (position == 0 || !IsIdentifier(code[position - 1]));
+
+            if (!nameStart)
+            {
+                if (script[position] == '$') shared.append(prefix);
+                else shared.push_back(script[position]);
+                position++;
+                continue;
+            }
+
+            size_t end = position + 1;
+            while (end < code.size() && IsIdentifier(code[end])) end++;
+
+            const std::string name = code.substr(position, end - position);
+            const bool definition = IsDefinition(code.substr(0, position));
+            shared.append(name[0] == '$' ? prefix + name.substr(1) : name);
+            position = end;
+
+            size_t paren = end;
+            while (paren < code.size() && isspace(static_cast<unsigned char>(code[paren]))) paren++;
+            if ((name[0] != '$' && passing.count(name) == 0) || paren >= code.size() || code[paren] != '(') continue;
+
+            size_t argument = paren + 1;
+            while (argument < code.size() && isspace(static_cast<unsigned char>(code[argument]))) argument++;
+
+            // A definition's lone void parameter is swapped out rather than kept next to self.
+            size_t afterVoid = argument + 4;
+            while (afterVoid < code.size() && isspace(static_cast<unsigned char>(code[afterVoid]))) afterVoid++;
+            const bool onlyVoid = definition && code.compare(argument, 4, "void") == 0
+                && afterVoid < code.size() && code[afterVoid] == ')';
+
+            shared.append(script, end, paren + 1 - end).append(definition ? "actor *self" : "self");
+            if (onlyVoid) position = afterVoid;
+            else if (argument < code.size() && code[argument] == ')') position = argument;
+            else
+            {
+                shared.append(", ");
+                position = argument;
+            }
+        }
+
+        return shared;
+    }
+
+    std::vector<std::string> ScriptRewriter::Prefixes(const std::vector<std::string> &scripts)
+    {
+        std::unordered_map<std::string, std::string> shared;
+        std::vector<std::string> prefixes;
+        int scriptCount = 0;
+
+        for (const auto &script : scripts)
+        {
+            const std::string prefix = Util::NewResourceName(scriptCount++);
+            if (HasState(script))
+            {
+                prefixes.push_back(prefix);
+                continue;
+            }
+
+            prefixes.push_back(shared.emplace(Normalize(script), prefix).first->second);
+        }
+
+        return prefixes;
+    }
+
+    bool ScriptRewriter::HasState(const std::string &script)
+    {
+        const std::string code = Mask(script);
+        size_t dollar = 0;
+
+        while ((dollar = code.find('$', dollar)) != std::string::npos)
+        {
+            size_t end = ++dollar;
+            while (end < code.size() && IsIdentifier(code[end])) end++;
+            while (end < code.size() && isspace(static_cast<unsigned char>(code[end]))) end++;
+            if (end >= code.size() || code[end] != '(') return true;
+        }
+
+        // Static locals keep their value between calls, so a function holding one can't be shared either.
+        int depth = 0;
+        for (size_t i = 0; i < code.size(); i++)
+        {
+            if (code[i] == '{') depth++;
+            else if (code[i] == '}') depth--;
+            else if (depth > 0 && code.compare(i, 6, "static") == 0 && (i == 0 || !IsIdentifier(code[i - 1]))
+                && (i + 6 >= code.size() || !IsIdentifier(code[i + 6]))) return true;
+        }
+
+        return false;
+    }
+
+    bool ScriptRewriter::Defines(const std::string &script, const std::string &function)
+    {
+        const std::string code = Mask(script);
+        size_t found = 0;
+
+        while ((found = code.find(function, found)) != std::string::npos)
+        {
+            size_t position = found + function.size();
+            const bool whole = (found == 0 || !IsIdentifier(code[found - 1]))
+                && (position >= code.size() || !IsIdentifier(code[position]));
+            found = position;
+            if (!whole) continue;
+
+            // Only a parameter list followed by a body makes a definition, not a call or a prototype.
+            while (position < code.size() && isspace(static_cast<unsigned char>(code[position]))) position++;
+            if (position >= code.size() || code[position] != '(') continue;
+
+            position = Closing(code, position) + 1;
+            while (position < code.size() && isspace(static_cast<unsigned char>(code[position]))) position++;
+            if (position >= code.size() || code[position] != '{') continue;
+
+            const size_t close = Closing(code, position);
+            for (size_t i = position + 1; i < close && i < code.size(); i++)
+            {
+                if (!isspace(static_cast<unsigned char>(code[i]))) return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::string ScriptRewriter::Mask(const std::string &script)
+    {
+        // Comments and the insides of string and character literals are blanked out, keeping line breaks,
+        // so only code is left and every offset still lines up with the script.
+        std::string code(script);
+        size_t i = 0;
+
+        while (i < code.size())
+        {
+            if (code.compare(i, 2, "//") == 0)
+            {
+                for (; i < code.size() && code[i] != '\n'; i++) code[i] = ' ';
+            }
+            else if (code.compare(i, 2, "/*") == 0)
+            {
+                const size_t end = std::min(code.find("*/", i + 2), code.size() - 2) + 2;
+                for (; i < end; i++) if (code[i] != '\n') code[i] = ' ';
+            }
+            else if (code[i] == '"' || code[i] == '\'')
+            {
+                const char quote = code[i++];
+
+                while (i < code.size() && script[i] != quote)
+                {
+                    if (script[i] == '\\' && i + 1 < code.size()) code[i++] = ' ';
+                    code[i++] = ' ';
+                }
+
+                i++;
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        return code;
+    }
+
+    std::set<std::string> ScriptRewriter::SelfFunctions(const std::string &code)
+    {
+        // Every $ function takes self, and so does any other function that calls one, so it has self to pass on.
+        std::vector<std::pair<std::string, std::pair<size_t, size_t>>> helpers;
+        std::set<std::string> passing;
+        size_t position = 0;
+
+        while (position < code.size())
+        {
+            if (code[position] == '{')
+            {
+                position = Closing(code, position) + 1;
+                continue;
+            }
+
+            const bool nameStart = code[position] == '$' || IsIdentifier(code[position]);
+            if (!nameStart || (position > 0 && IsIdentifier(code[position - 1])))
+            {
+                position++;
+                continue;
+            }
+
+            size_t end = position + 1;
+            while (end < code.size() && IsIdentifier(code[end])) end++;
+            const std::string name = code.substr(position, end - position);
+            position = end;
+
+            while (end < code.size() && isspace(static_cast<unsigned char>(code[end]))) end++;
+            if (end >= code.size() || code[end] != '(') continue;
+
+            end = Closing(code, end) + 1;
+            while (end < code.size() && isspace(static_cast<unsigned char>(code[end]))) end++;
+            if (end >= code.size() || code[end] != '{') continue;
+
+            const size_t close = Closing(code, end);
+            if (name[0] == '$') passing.insert(name);
+            else helpers.push_back({ name, { end, close } });
+            position = close + 1;
+        }
+
+        for (bool added = true; added;)
+        {
+            added = false;
+
+            for (const auto &helper : helpers)
+            {
+                if (passing.count(helper.first) > 0) continue;
+                const auto &body = helper.second;
+                if (!Calls(code.substr(body.first, body.second - body.first), passing)) continue;
+
+                passing.insert(helper.first);
+                added = true;
+            }
+        }
+
+        return passing;
+    }
+
+    bool ScriptRewriter::Calls(const std::string &body, const std::set<std::string> &passing)
+    {
+        for (size_t position = 0; position < body.size();)
+        {
+            if (!(body[position] == '$' || IsIdentifier(body[position])))
+            {
+                position++;
+                continue;
+            }
+
+            size_t end = position;
+            while (end < body.size() && (body[end] == '$' || IsIdentifier(body[end]))) end++;
+            const std::string name = body.substr(position, end - position);
+            position = end;
+
+            while (end < body.size() && isspace(static_cast<unsigned char>(body[end]))) end++;
+            if (end < body.size() && body[end] == '(' && (name[0] == '$' || passing.count(name) > 0)) return true;
+        }
+
+        return false;
+    }
+
+    size_t ScriptRewriter::Closing(const std::string &code, size_t open)
+    {
+        const char opening = code[open], closing = opening == '(' ? ')' : '}';
+        int depth = 0;
+
+        for (size_t i = open; i < code.size(); i++)
+        {
+            if (code[i] == opening) depth++;
+            else if (code[i] == closing && --depth == 0) return i;
+        }
+
+        return code.size();
+    }
+
+    bool ScriptRewriter::IsDefinition(const std::string &before)
+    {
+        // Functions are defined after their return type while calls follow an operator, a bracket or a keyword.
+        size_t end = before.size();
+        while (end > 0 && isspace(static_cast<unsigned char>(before[end - 1]))) end--;
+        if (end == 0) return false;
+
+        if (before[end - 1] != '*')
+        {
+            if (!IsIdentifier(before[end - 1])) return false;
+
+            size_t start = end;
+            while (start > 0 && IsIdentifier(before[start - 1])) start--;
+            return !IsCallKeyword(before.substr(start, end - start));
+        }
+
+        // A star only makes a pointer return type when the words before it start the declaration,
+        // otherwise it's multiplying whatever the call returns.
+        while (end > 0 && (before[end - 1] == '*' || isspace(static_cast<unsigned char>(before[end - 1])))) end--;
+        if (end == 0 || !IsIdentifier(before[end - 1])) return false;
+
+        while (end > 0 && IsIdentifier(before[end - 1]))
+        {
+            size_t start = end;
+            while (start > 0 && IsIdentifier(before[start - 1])) start--;
+            if (IsCallKeyword(before.substr(start, end - start))) return false;
+
+            end = start;
+            while (end > 0 && isspace(static_cast<unsigned char>(before[end - 1]))) end--;
+        }
+
+        if (end == 0 || before[end - 1] == ';' || before[end - 1] == '{' || before[end - 1] == '}') return true;
+
+        // Declarations can also follow a preprocessor line such as an include.
+        size_t line = before.rfind('\n', end - 1);
+        line = line == std::string::npos ? 0 : line + 1;
+        while (line < end && isspace(static_cast<unsigned char>(before[line]))) line++;
+        return before[line] == '#';
+    }
+
+    bool ScriptRewriter::IsCallKeyword(const std::string &word)
+    {
+        return word == "return" || word == "else" || word == "case" || word == "do" || word == "sizeof";
+    }
+
+    bool ScriptRewriter::IsIdentifier(char c)
+    {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _SCRIPTREWRITER_H_
+#define _SCRIPTREWRITER_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace UltraEd
+{
+    // Turns actor scripts into C the engine compiles, where a script shared by several actors is written once
+    // and told which actor it's running for through a self parameter.
+    class ScriptRewriter
+    {
+    public:
+        // Scripts that only differ in line endings or trailing whitespace come out the same.
+        static std::string Normalize(const std::string &script);
+
+        // Replaces each $ with the prefix and passes self as the first argument of every $ function, and of
+        // any other function that calls one, adding it to their definitions and to the calls between them.
+        static std::string Share(const std::string &script, const std::string &prefix);
+
+        // Picks the prefix each script's $ names are replaced with. Actors with the same script take the prefix of
+        // the first one, unless it keeps per-actor state.
+        static std::vector<std::string> Prefixes(const std::vector<std::string> &scripts);
+
+        // True when the script declares $ variables or static locals, which each actor running it needs
+        // its own copy of.
+        static bool HasState(const std::string &script);
+
+        // True when the script defines the function with more than whitespace and comments in its body.
+        static bool Defines(const std::string &script, const std::string &function);
+
+    private:
+        ScriptRewriter() {}
+        static std::string Mask(const std::string &script);
+        static std::set<std::string> SelfFunctions(const std::string &code);
+        static bool Calls(const std::string &body, const std::set<std::string> &passing);
+        static size_t Closing(const std::string &code, size_t open);
+        static bool IsDefinition(const std::string &before);
+        static bool IsCallKeyword(const std::string &word);
+        static bool IsIdentifier(char c);
+    };
+}
+
+#endif
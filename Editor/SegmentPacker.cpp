@@ -0,0 +1,46 @@
+#include <FastLZ/fastlz.h>
+#include "SegmentPacker.h"
+
+namespace UltraEd
+{
+    RomBuffer SegmentPacker::Pack(const RomBuffer &segment)
+    {
+        const auto &data = segment.Data();
+        const size_t limit = data.size() - data.size() * MinSavingsPercent / 100;
+        std::vector<unsigned char> best;
+
+        // FastLZ won't take blocks under 16 bytes. Both levels are tried since either can come out smaller.
+        if (data.size() >= 16)
+        {
+            for (int level = 1; level <= 2; level++)
+            {
+                const auto compressed = Compress(data, level);
+                if (compressed.size() <= limit && (best.empty() || compressed.size() < best.size()))
+                {
+                    best = compressed;
+                }
+            }
+        }
+
+        RomBuffer packed;
+        packed.Write32(static_cast<unsigned int>(data.size()));
+        packed.Write32(static_cast<unsigned int>(best.size()));
+        packed.Write(best.empty() ? data.data() : best.data(), best.empty() ? data.size() : best.size());
+        return packed;
+    }
+
+    bool SegmentPacker::IsPacked(const RomBuffer &packed)
+    {
+        return packed.Size() >= HeaderSize && RomBuffer::Read32(packed.Data().data() + 4) > 0;
+    }
+
+    std::vector<unsigned char> SegmentPacker::Compress(const std::vector<unsigned char> &data, int level)
+    {
+        // Output can grow by up to 5% on data that doesn't compress and is never smaller than 66 bytes.
+        std::vector<unsigned char> compressed(data.size() + data.size() / 16 + 66);
+        const int size = fastlz_compress_level(level, data.data(), static_cast<int>(data.size()), compressed.data());
+
+        compressed.resize(static_cast<size_t>(size));
+        return compressed;
+    }
+}
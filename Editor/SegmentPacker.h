@@ -0,0 +1,28 @@
+#ifndef _SEGMENTPACKER_H_
+#define _SEGMENTPACKER_H_
+
+#include "RomBuffer.h"
+
+namespace UltraEd
+{
+    // Prefixes a segment with the header the engine's loader reads first: its unpacked size followed by
+    // its FastLZ compressed size, which is zero when the segment is stored as-is.
+    class SegmentPacker
+    {
+    public:
+        static RomBuffer Pack(const RomBuffer &segment);
+        static bool IsPacked(const RomBuffer &packed);
+
+    public:
+        static const int HeaderSize = 8;
+
+        // Decompressing costs CPU time at load so smaller savings than this aren't worth the PI time they save.
+        static const int MinSavingsPercent = 10;
+
+    private:
+        SegmentPacker() {}
+        static std::vector<unsigned char> Compress(const std::vector<unsigned char> &data, int level);
+    };
+}
+
+#endif
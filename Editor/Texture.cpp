@@ -1,10 +1,12 @@
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
 
 #include <STB/stb_image.h>
-#include <STB/stb_image_write.h>
 #include "Project.h"
+#include "RomBuffer.h"
+#include "SegmentPacker.h"
 #include "Texture.h"
+#include "TextureConverter.h"
+#include "TextureTiler.h"
 
 namespace UltraEd
 {
@@ -40,27 +42,40 @@ namespace UltraEd
         return m_texture;
     }
 
-    std::unique_ptr<unsigned char> Texture::GetPngData()
+    std::unique_ptr<unsigned char> Texture::GetPixelData()
     {
         int width, height, channels;
-        unsigned char *data = stbi_load(GetPath().string().c_str(), &width, &height, &channels, 3);
+        unsigned char *data = stbi_load(GetPath().string().c_str(), &width, &height, &channels, 4);
 
         return std::unique_ptr<unsigned char>(data);
     }
 
-    bool Texture::WritePngData(const std::filesystem::path &path)
+    bool Texture::WriteTexelData(const std::filesystem::path &path)
     {
         const auto dimensions = Dimensions();
-        const auto pngData = GetPngData();
+        const auto pixelData = GetPixelData();
 
-        if (pngData)
+        if (pixelData)
         {
-            return stbi_write_png(path.string().c_str(), dimensions[0], dimensions[1], 3, pngData.get(), 0) == 1;
+            RomBuffer buffer;
+            const auto format = TextureConverter::ChooseFormat(pixelData.get(), dimensions[0], dimensions[1]);
+            const auto tiled = TextureTiler::TilePixels(pixelData.get(), TextureTiler::Layout(dimensions, format));
+            TextureConverter::Write(buffer, format, tiled.data(), dimensions[0], dimensions[1]);
+            return SegmentPacker::Pack(buffer).WriteFile(path);
         }
 
         return false;
     }
 
+    TexelFormat Texture::Format()
+    {
+        const auto dimensions = Dimensions();
+        const auto pixelData = GetPixelData();
+
+        return pixelData ? TextureConverter::ChooseFormat(pixelData.get(), dimensions[0], dimensions[1])
+            : TexelFormat::Rgba16;
+    }
+
     const boost::uuids::uuid &Texture::GetId()
     {
         return m_textureId;
@@ -85,7 +100,7 @@ namespace UltraEd
 
     bool Texture::IsValid(std::string &reason)
     {
-        const std::vector<int> validSizes { 4, 8, 16, 32, 64 };
+        const std::vector<int> validSizes { 4, 8, 16, 32, 64, 128, 256 };
         const auto dimensions = Dimensions();
         const auto isXValid = std::find(validSizes.cbegin(), validSizes.cend(), dimensions[0]) != validSizes.cend();
         const auto isYValid = std::find(validSizes.cbegin(), validSizes.cend(), dimensions[1]) != validSizes.cend();
@@ -4,6 +4,7 @@
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/nil_generator.hpp>
 #include <d3dx9.h>
+#include "TextureConverter.h"
 
 namespace UltraEd
 {
@@ -14,8 +15,9 @@ namespace UltraEd
         ~Texture();
         bool Load(IDirect3DDevice9 *device, const boost::uuids::uuid &textureId);
         LPDIRECT3DTEXTURE9 Get();
-        std::unique_ptr<unsigned char> GetPngData();
-        bool WritePngData(const std::filesystem::path &path);
+        std::unique_ptr<unsigned char> GetPixelData();
+        bool WriteTexelData(const std::filesystem::path &path);
+        TexelFormat Format();
         const boost::uuids::uuid &GetId();
         std::filesystem::path GetPath();
         bool IsLoaded();
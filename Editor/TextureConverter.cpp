@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <map>
+#include "TextureConverter.h"
+
+namespace UltraEd
+{
+    unsigned short TextureConverter::ToRgba5551(const unsigned char *pixel)
+    {
+        return static_cast<unsigned short>(((pixel[0] >> 3) << 11) | ((pixel[1] >> 3) << 6) |
+            ((pixel[2] >> 3) << 1) | (pixel[3] >= 128 ? 1 : 0));
+    }
+
+    TexelFormat TextureConverter::ChooseFormat(const unsigned char *pixels, int width, int height)
+    {
+        const int texels = width * height;
+        std::vector<bool> seen(0x10000);
+        int colors = 0;
+
+        for (int i = 0; i < texels && colors <= 256; i++)
+        {
+            const unsigned short color = ToRgba5551(&pixels[i * 4]);
+            if (!seen[color]) colors++;
+            seen[color] = true;
+        }
+
+        // Indexed formats are used whenever they lose nothing, and load block needs rows of at least 8 bytes.
+        if (colors <= 16 && width >= 16 && texels <= MaxCi4Texels) return TexelFormat::Ci4;
+        if (colors <= 256 && width >= 8 && texels <= MaxCi8Texels) return TexelFormat::Ci8;
+        if (texels <= MaxRgba16Texels) return TexelFormat::Rgba16;
+
+        // Too large for one load either way, so it's tiled in whichever format keeps every color.
+        return colors <= 16 ? TexelFormat::Ci4 : colors <= 256 ? TexelFormat::Ci8 : TexelFormat::Rgba16;
+    }
+
+    void TextureConverter::Write(RomBuffer &buffer, TexelFormat format, const unsigned char *pixels, int width,
+        int height)
+    {
+        if (format == TexelFormat::Rgba16)
+            WriteRgba16(buffer, pixels, width, height);
+        else
+            WriteCi(buffer, format, pixels, width, height);
+    }
+
+    void TextureConverter::WriteRgba16(RomBuffer &buffer, const unsigned char *pixels, int width, int height)
+    {
+        for (int i = 0; i < width * height; i++)
+        {
+            buffer.Write16(ToRgba5551(&pixels[i * 4]));
+        }
+    }
+
+    void TextureConverter::WriteCi(RomBuffer &buffer, TexelFormat format, const unsigned char *pixels, int width,
+        int height)
+    {
+        const int colors = PaletteColors(format);
+        std::vector<unsigned short> texels;
+        std::vector<unsigned char> indices;
+
+        for (int i = 0; i < width * height; i++)
+        {
+            texels.push_back(ToRgba5551(&pixels[i * 4]));
+        }
+
+        // The palette is always written in full so the texels start at a fixed offset.
+        auto palette = Quantize(texels, colors, indices);
+        palette.resize(colors);
+
+        for (const auto &color : palette)
+        {
+            buffer.Write16(color);
+        }
+
+        if (format == TexelFormat::Ci8)
+        {
+            buffer.Write(indices.data(), indices.size());
+            return;
+        }
+
+        // The first of each pair of texels goes in the high nibble.
+        for (size_t i = 0; i < indices.size(); i += 2)
+        {
+            const unsigned char second = i + 1 < indices.size() ? indices[i + 1] : 0;
+            buffer.Write8(static_cast<unsigned char>((indices[i] << 4) | second));
+        }
+    }
+
+    std::vector<unsigned short> TextureConverter::Quantize(const std::vector<unsigned short> &texels, int colors,
+        std::vector<unsigned char> &indices)
+    {
+        struct Color
+        {
+            int channels[4];
+            int count;
+        };
+
+        // Each channel is kept at 5 bits, with the alpha bit stretched to the same range.
+        std::map<unsigned short, int> counts;
+        for (const auto &texel : texels) counts[texel]++;
+
+        std::vector<Color> distinct;
+        for (const auto &entry : counts)
+        {
+            const unsigned short c = entry.first;
+            distinct.push_back({ { (c >> 11) & 31, (c >> 6) & 31, (c >> 1) & 31, (c & 1) * 31 }, entry.second });
+        }
+
+        // Median cut: keep splitting the box with the widest channel at the texel weighted median of that channel.
+        std::vector<std::pair<size_t, size_t>> boxes { { 0, distinct.size() } };
+        while (static_cast<int>(boxes.size()) < colors)
+        {
+            int widest = -1, widestBox = -1, widestChannel = 0;
+
+            for (size_t i = 0; i < boxes.size(); i++)
+            {
+                if (boxes[i].second - boxes[i].first < 2) continue;
+
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    const auto range = std::minmax_element(distinct.begin() + boxes[i].first,
+                        distinct.begin() + boxes[i].second, [channel](const Color &a, const Color &b) {
+                            return a.channels[channel] < b.channels[channel];
+                        });
+                    const int width = range.second->channels[channel] - range.first->channels[channel];
+
+                    if (width > widest)
+                    {
+                        widest = width;
+                        widestBox = static_cast<int>(i);
+                        widestChannel = channel;
+                    }
+                }
+            }
+
+            if (widest <= 0) break;
+
+            auto &box = boxes[widestBox];
+            const auto begin = distinct.begin() + box.first, end = distinct.begin() + box.second;
+            std::sort(begin, end, [widestChannel](const Color &a, const Color &b) {
+                return a.channels[widestChannel] < b.channels[widestChannel];
+            });
+
+            int total = 0, half = 0;
+            for (auto color = begin; color != end; color++) total += color->count;
+
+            auto split = begin;
+            while (split + 1 < end && (half += split->count) * 2 < total) split++;
+
+            // Both halves keep at least one color.
+            const size_t middle = std::min<size_t>(split - distinct.begin() + 1, box.second - 1);
+            const size_t last = box.second;
+            box.second = middle;
+            boxes.push_back({ middle, last });
+        }
+
+        std::vector<unsigned short> palette;
+        std::map<unsigned short, unsigned char> lookup;
+
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            int sums[4] = {}, total = 0;
+
+            for (size_t j = boxes[i].first; j < boxes[i].second; j++)
+            {
+                for (int channel = 0; channel < 4; channel++)
+                    sums[channel] += distinct[j].channels[channel] * distinct[j].count;
+                total += distinct[j].count;
+            }
+
+            int average[4];
+            for (int channel = 0; channel < 4; channel++) average[channel] = (sums[channel] + total / 2) / total;
+
+            palette.push_back(static_cast<unsigned short>((average[0] << 11) | (average[1] << 6) | (average[2] << 1)
+                | (average[3] >= 16 ? 1 : 0)));
+
+            for (size_t j = boxes[i].first; j < boxes[i].second; j++)
+            {
+                const Color &c = distinct[j];
+                lookup[static_cast<unsigned short>((c.channels[0] << 11) | (c.channels[1] << 6) | (c.channels[2] << 1)
+                    | (c.channels[3] ? 1 : 0))] = static_cast<unsigned char>(i);
+            }
+        }
+
+        indices.clear();
+        for (const auto &texel : texels) indices.push_back(lookup[texel]);
+
+        return palette;
+    }
+
+    int TextureConverter::PaletteColors(TexelFormat format)
+    {
+        return format == TexelFormat::Ci4 ? 16 : format == TexelFormat::Ci8 ? 256 : 0;
+    }
+}
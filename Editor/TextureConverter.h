@@ -0,0 +1,36 @@
+#ifndef _TEXTURECONVERTER_H_
+#define _TEXTURECONVERTER_H_
+
+#include <vector>
+#include "RomBuffer.h"
+
+namespace UltraEd
+{
+    // Color indexed formats store an RGBA5551 palette ahead of the indices.
+    enum class TexelFormat { Rgba16, Ci8, Ci4 };
+
+    // Converts 32-bit RGBA pixels into texel formats the RDP can load from RDRAM without any decoding.
+    class TextureConverter
+    {
+    public:
+        static unsigned short ToRgba5551(const unsigned char *pixel);
+        static TexelFormat ChooseFormat(const unsigned char *pixels, int width, int height);
+        static void Write(RomBuffer &buffer, TexelFormat format, const unsigned char *pixels, int width, int height);
+        static void WriteRgba16(RomBuffer &buffer, const unsigned char *pixels, int width, int height);
+        static void WriteCi(RomBuffer &buffer, TexelFormat format, const unsigned char *pixels, int width, int height);
+        static std::vector<unsigned short> Quantize(const std::vector<unsigned short> &texels, int colors,
+            std::vector<unsigned char> &indices);
+        static int PaletteColors(TexelFormat format);
+
+    public:
+        // The palette takes the upper half of TMEM, so indexed texels only get the lower 2 KB.
+        static const int MaxRgba16Texels = 2048;
+        static const int MaxCi8Texels = 2048;
+        static const int MaxCi4Texels = 4096;
+
+    private:
+        TextureConverter() {}
+    };
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include "TextureTiler.h"
+
+namespace UltraEd
+{
+    TextureLayout TextureTiler::Layout(const std::array<int, 2> &size, TexelFormat format)
+    {
+        const int maxTexels = format == TexelFormat::Ci4 ? TextureConverter::MaxCi4Texels
+            : format == TexelFormat::Ci8 ? TextureConverter::MaxCi8Texels : TextureConverter::MaxRgba16Texels;
+
+        if (size[0] * size[1] <= maxTexels) return { size, size, format };
+
+        const int width = std::min(size[0], static_cast<int>(MaxTileWidth));
+        return { size, { width, std::min(size[1], maxTexels / width) }, format };
+    }
+
+    std::vector<unsigned char> TextureTiler::TilePixels(const unsigned char *pixels, const TextureLayout &layout)
+    {
+        const int width = layout.size[0], tileWidth = layout.tileSize[0], tileHeight = layout.tileSize[1];
+        std::vector<unsigned char> tiled;
+
+        for (int tileY = 0; tileY < layout.size[1]; tileY += tileHeight)
+        {
+            for (int tileX = 0; tileX < width; tileX += tileWidth)
+            {
+                for (int y = tileY; y < tileY + tileHeight; y++)
+                {
+                    const unsigned char *row = &pixels[(y * width + tileX) * 4];
+                    tiled.insert(tiled.end(), row, row + tileWidth * 4);
+                }
+            }
+        }
+
+        return tiled;
+    }
+
+    std::vector<std::pair<int, std::vector<N64Vertex>>> TextureTiler::Split(const std::vector<N64Vertex> &vertices,
+        const TextureLayout &layout)
+    {
+        if (!layout.IsTiled()) return { { 0, vertices } };
+
+        std::vector<std::vector<N64Vertex>> tiles(layout.TileCount());
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        {
+            SplitPolygon({ vertices[i], vertices[i + 1], vertices[i + 2] }, layout, tiles);
+        }
+
+        // Tiles are drawn in row order so each one a mesh uses is loaded once per draw.
+        std::vector<std::pair<int, std::vector<N64Vertex>>> groups;
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            if (!tiles[i].empty()) groups.push_back({ static_cast<int>(i), tiles[i] });
+        }
+
+        return groups;
+    }
+
+    int TextureTiler::TileOffset(const TextureLayout &layout, int tile)
+    {
+        const int bits = layout.format == TexelFormat::Ci4 ? 4 : layout.format == TexelFormat::Ci8 ? 8 : 16;
+        return TextureConverter::PaletteColors(layout.format) * 2
+            + tile * (layout.tileSize[0] * layout.tileSize[1] * bits / 8);
+    }
+
+    void TextureTiler::SplitPolygon(const std::vector<N64Vertex> &polygon, const TextureLayout &layout,
+        std::vector<std::vector<N64Vertex>> &tiles)
+    {
+        // Texture coordinates are s10.5 texels so each tile edge falls on a multiple of its size shifted up by 5.
+        const int span[2] = { layout.tileSize[0] << 5, layout.tileSize[1] << 5 };
+        int cell[2];
+
+        for (int axis = 0; axis < 2; axis++)
+        {
+            const auto range = std::minmax_element(polygon.begin(), polygon.end(),
+                [axis](const N64Vertex &a, const N64Vertex &b) { return a.tc[axis] < b.tc[axis]; });
+            const int low = range.first->tc[axis], high = range.second->tc[axis];
+            const int edge = (FloorDiv(low, span[axis]) + 1) * span[axis];
+
+            if (edge < high)
+            {
+                // Clip against the first tile edge crossing the polygon and keep cutting what's on either side.
+                std::vector<N64Vertex> before, after;
+                for (size_t i = 0; i < polygon.size(); i++)
+                {
+                    const N64Vertex &a = polygon[i], &b = polygon[(i + 1) % polygon.size()];
+                    const int sideA = a.tc[axis] - edge, sideB = b.tc[axis] - edge;
+
+                    if (sideA <= 0) before.push_back(a);
+                    if (sideA >= 0) after.push_back(a);
+
+                    if ((sideA < 0 && sideB > 0) || (sideA > 0 && sideB < 0))
+                    {
+                        const N64Vertex cut = Intersect(a, b, axis, edge);
+                        before.push_back(cut);
+                        after.push_back(cut);
+                    }
+                }
+
+                if (before.size() >= 3) SplitPolygon(before, layout, tiles);
+                if (after.size() >= 3) SplitPolygon(after, layout, tiles);
+                return;
+            }
+
+            cell[axis] = FloorDiv((low + high) / 2, span[axis]);
+        }
+
+        // Repeating textures wrap back around to the first tile, with coordinates made relative to the tile.
+        const int tilesX = layout.size[0] / layout.tileSize[0], tilesY = layout.size[1] / layout.tileSize[1];
+        const int tile = ((cell[1] % tilesY + tilesY) % tilesY) * tilesX + (cell[0] % tilesX + tilesX) % tilesX;
+
+        std::vector<N64Vertex> local(polygon);
+        for (auto &vertex : local)
+        {
+            vertex.tc[0] = static_cast<short>(vertex.tc[0] - cell[0] * span[0]);
+            vertex.tc[1] = static_cast<short>(vertex.tc[1] - cell[1] * span[1]);
+        }
+
+        for (size_t i = 1; i + 1 < local.size(); i++)
+        {
+            tiles[tile].insert(tiles[tile].end(), { local[0], local[i], local[i + 1] });
+        }
+    }
+
+    N64Vertex TextureTiler::Intersect(const N64Vertex &a, const N64Vertex &b, int axis, int value)
+    {
+        // Always interpolate from the same end so triangles sharing the edge get the identical vertex.
+        const bool swap = memcmp(&a, &b, sizeof(N64Vertex)) > 0;
+        const N64Vertex &from = swap ? b : a, &to = swap ? a : b;
+        const double t = static_cast<double>(value - from.tc[axis]) / (to.tc[axis] - from.tc[axis]);
+        auto lerp = [t](int start, int end) { return static_cast<int>(std::lround(start + (end - start) * t)); };
+
+        N64Vertex cut = from;
+        for (int i = 0; i < 3; i++) cut.ob[i] = static_cast<short>(lerp(from.ob[i], to.ob[i]));
+        for (int i = 0; i < 2; i++) cut.tc[i] = static_cast<short>(lerp(from.tc[i], to.tc[i]));
+        for (int i = 0; i < 4; i++) cut.cn[i] = static_cast<unsigned char>(lerp(from.cn[i], to.cn[i]));
+        cut.tc[axis] = static_cast<short>(value);
+        return cut;
+    }
+
+    int TextureTiler::FloorDiv(int value, int divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+}
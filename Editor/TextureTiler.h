@@ -0,0 +1,53 @@
+#ifndef _TEXTURETILER_H_
+#define _TEXTURETILER_H_
+
+#include <array>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "TextureConverter.h"
+
+namespace UltraEd
+{
+    // How a texture is stored in its segment. Textures too large for one TMEM load are split into tiles
+    // that each fit, stored one after another in row order after the palette.
+    struct TextureLayout
+    {
+        std::array<int, 2> size;
+        std::array<int, 2> tileSize;
+        TexelFormat format;
+
+        bool IsTiled() const { return tileSize != size; }
+        int TileCount() const { return (size[0] / tileSize[0]) * (size[1] / tileSize[1]); }
+    };
+
+    // Triangles of one level of detail that sample from the same tile.
+    struct TileGroup
+    {
+        int tile;
+        IndexedMesh mesh;
+    };
+
+    // Splits large textures into TMEM sized tiles and cuts meshes along the tile edges to match.
+    class TextureTiler
+    {
+    public:
+        static TextureLayout Layout(const std::array<int, 2> &size, TexelFormat format);
+        static std::vector<unsigned char> TilePixels(const unsigned char *pixels, const TextureLayout &layout);
+        static std::vector<std::pair<int, std::vector<N64Vertex>>> Split(const std::vector<N64Vertex> &vertices,
+            const TextureLayout &layout);
+        static int TileOffset(const TextureLayout &layout, int tile);
+
+    public:
+        // Tiles keep full 64 texel rows where the texture has them and take as many rows as still fit.
+        static const int MaxTileWidth = 64;
+
+    private:
+        TextureTiler() {}
+        static void SplitPolygon(const std::vector<N64Vertex> &polygon, const TextureLayout &layout,
+            std::vector<std::vector<N64Vertex>> &tiles);
+        static N64Vertex Intersect(const N64Vertex &a, const N64Vertex &b, int axis, int value);
+        static int FloorDiv(int value, int divisor);
+    };
+}
+
+#endif
@@ -1,204 +1,271 @@
 #include <nusys.h>
 #include <malloc.h>
-#include <string.h>
-#include <stdio.h>
-#include "upng.h"
 #include "actor.h"
 #include "utilities.h"
+#include "pool.h"
+#include "loader.h"
 
-actor *loadModel(void *dataStart, void *dataEnd, double positionX, double positionY, double positionZ,
-    double rotX, double rotY, double rotZ, double angle, double scaleX, double scaleY, double scaleZ, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider)
+// Swaps the segment numbers baked into a mesh's display lists for the RAM addresses of its data and texture
+// the first time the segment arrives, then points the actor at its display lists.
+static void meshLoaded(void *segmentData, int size, int first, void *target)
+{
+    const int slot = ACTOR_SLOT((actor*)target);
+    mesh *loaded = &actorModels[slot].mesh;
+    u8 *data = (u8*)segmentData;
+    meshHeader *header = (meshHeader*)data;
+
+    if (first)
+    {
+        u32 *relocations = (u32*)(data + header->relocationOffset);
+
+        for (int i = 0; i < header->relocationCount; i++)
+        {
+            u32 *address = (u32*)(data + relocations[i]);
+            void *base = (*address >> 24) == TEXTURE_SEGMENT ? (void*)actorModels[slot].texture : (void*)data;
+            *address = OS_K0_TO_PHYSICAL(base) + (*address & 0x00FFFFFF);
+        }
+
+        // The RSP reads straight from RDRAM so the patched words can't be left in the data cache.
+        osWritebackDCache(data, size);
+    }
+
+    loaded->textureLoad = header->textureLoadOffset > 0 ? (Gfx*)(data + header->textureLoadOffset) : NULL;
+    loaded->lodCount = header->lodCount;
+
+    for (int i = 0; i < header->lodCount; i++)
+    {
+        loaded->geometry[i] = (Gfx*)(data + header->geometryOffset[i]);
+    }
+
+    loaded->stateKey = header->stateKey;
+    loaded->boundsCenter.x = header->boundsCenter[0];
+    loaded->boundsCenter.y = header->boundsCenter[1];
+    loaded->boundsCenter.z = header->boundsCenter[2];
+    loaded->boundsRadius = header->boundsRadius;
+    loaded->tiled = header->tiled;
+
+    // Drawing treats the state list as the sign the mesh is ready, and the bounds composed before now
+    // were missing it.
+    loaded->state = (Gfx*)(data + header->stateOffset);
+    actorStates[slot].dirty = 1;
+}
+
+static void textureLoaded(void *segmentData, int size, int first, void *target)
+{
+    actorModels[ACTOR_SLOT((actor*)target)].texture = (unsigned short*)segmentData;
+}
+
+int isActorLoaded(actor *target)
+{
+    return target->type != Model || actorModels[ACTOR_SLOT(target)].mesh.state != NULL;
+}
+
+actor *loadModel(void *dataStart, void *dataEnd, float positionX, float positionY, float positionZ,
+    float rotX, float rotY, float rotZ, float angle, float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider,
+    float lodDistance1, float lodDistance2)
 {
     return loadTexturedModel(dataStart, dataEnd,
-        NULL, NULL, 0, 0, positionX, positionY, positionZ, rotX, rotY, rotZ, angle, scaleX, scaleY, scaleZ, 
-        centerX, centerY, centerZ, radius, extentX, extentY, extentZ, collider);
+        NULL, NULL, 0, 0, positionX, positionY, positionZ, rotX, rotY, rotZ, angle,
+        centerX, centerY, centerZ, radius, extentX, extentY, extentZ, collider, lodDistance1, lodDistance2);
 }
 
 actor *loadTexturedModel(void *dataStart, void *dataEnd, void *textureStart, void *textureEnd,
-    int textureWidth, int textureHeight, double positionX, double positionY, double positionZ, double rotX, 
-    double rotY, double rotZ, double angle, double scaleX, double scaleY, double scaleZ, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider)
+    int textureWidth, int textureHeight, float positionX, float positionY, float positionZ, float rotX, 
+    float rotY, float rotZ, float angle, float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider,
+    float lodDistance1, float lodDistance2)
 {
-    unsigned char dataBuffer[200000];
-    unsigned char textureBuffer[200000];
-    int dataSize = dataEnd - dataStart;
-    int textureSize = textureEnd - textureStart;
     actor *newModel;
+    actorModel *model;
 
-    // Transfer from ROM the model mesh data and texture.
-    rom_2_ram(dataStart, dataBuffer, dataSize);
-    rom_2_ram(textureStart, textureBuffer, textureSize);
+    newModel = allocActor(0);
+    if (newModel == NULL) return NULL;
 
-    newModel = (actor*)malloc(sizeof(actor));
+    model = &actorModels[ACTOR_SLOT(newModel)];
     newModel->visible = 1;
     newModel->type = Model;
     newModel->collider = collider;
-    newModel->texture = NULL;
-    newModel->textureWidth = textureWidth;
-    newModel->textureHeight = textureHeight;
-
-    newModel->center.x = centerX;
-    newModel->center.y = centerY;
-    newModel->center.z = centerZ;
-    newModel->radius = radius;
-
-    newModel->extents.x = extentX;
-    newModel->extents.y = extentY;
-    newModel->extents.z = extentZ;
-
-    // Read how many vertices for this mesh.
-    int vertexCount = 0;
-    char *line = (char*)strtok(dataBuffer, "\n");
-    sscanf(line, "%i", &vertexCount);
-    newModel->mesh.vertices = (Vtx*)malloc(vertexCount * sizeof(Vtx));
-    newModel->mesh.vertexCount = vertexCount;
-
-    // Gather all of the X, Y, and Z vertex info.
-    for (int i = 0; i < vertexCount; i++)
+    newModel->collide = NULL;
+    model->texture = NULL;
+    model->textureWidth = textureWidth;
+    model->textureHeight = textureHeight;
+
+    newModel->center.x = SCALAR(centerX);
+    newModel->center.y = SCALAR(centerY);
+    newModel->center.z = SCALAR(centerZ);
+    newModel->radius = SCALAR(radius);
+
+    newModel->extents.x = SCALAR(extentX);
+    newModel->extents.y = SCALAR(extentY);
+    newModel->extents.z = SCALAR(extentZ);
+
+    model->lod = 0;
+    model->lodDistances[0] = lodDistance1;
+    model->lodDistances[1] = lodDistance2;
+
+    // Textures are converted to RGBA5551 or CI4 and CI8 with an RGBA5551 palette at build time so they are
+    // ready to load into TMEM.
+    if (textureEnd - textureStart > 0)
     {
-        double x, y, z, r, g, b, a, s, t;
-        line = (char*)strtok(NULL, "\n");
-        sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf %lf", &x, &y, &z, &r, &g, &b, &a, &s, &t);
-
-        newModel->mesh.vertices[i].v.ob[0] = x * scaleX * 100;
-        newModel->mesh.vertices[i].v.ob[1] = y * scaleY * 100;
-        newModel->mesh.vertices[i].v.ob[2] = -z * scaleZ * 100;
-        newModel->mesh.vertices[i].v.flag = 0;
-        newModel->mesh.vertices[i].v.tc[0] = (int)(s * textureWidth) << 5;
-        newModel->mesh.vertices[i].v.tc[1] = (int)(t * textureHeight) << 5;
-        newModel->mesh.vertices[i].v.cn[0] = r * 255;
-        newModel->mesh.vertices[i].v.cn[1] = g * 255;
-        newModel->mesh.vertices[i].v.cn[2] = b * 255;
-        newModel->mesh.vertices[i].v.cn[3] = a * 255;
+        queueSegment(textureStart, textureLoaded, newModel);
     }
 
+    // The mesh segment holds the vertices and the display lists that draw them, shared by every actor using it.
+    // It's queued after the texture, so the texture has always arrived by the time the mesh is patched.
+    model->mesh.state = NULL;
+    queueSegment(dataStart, meshLoaded, newModel);
+
     // Entire axis can't be zero or it won't render.
     if (rotX == 0.0 && rotY == 0.0 && rotZ == 0.0) rotZ = 1;
 
-    newModel->position.x = positionX;
-    newModel->position.y = positionY;
-    newModel->position.z = -positionZ;
-    newModel->scale.x = 0.01;
-    newModel->scale.y = 0.01;
-    newModel->scale.z = 0.01;
-    newModel->rotationAxis.x = rotX;
-    newModel->rotationAxis.y = rotY;
-    newModel->rotationAxis.z = -rotZ;
-    newModel->rotationAngle = -angle;
-
-    // Load in the png texture data.
-    upng_t *png = upng_new_from_bytes(textureBuffer, textureSize);
-    if (png != NULL)
-    {
-        upng_decode(png);
-        if (upng_get_error(png) == UPNG_EOK)
-        {
-            // Convert texture data from 24bpp to 16bpp in RGB5551 format.
-            newModel->texture = image_24_to_16(upng_get_buffer(png), textureWidth, textureHeight);
-        }
-        upng_free(png);
-    }
+    newModel->position.x = SCALAR(positionX);
+    newModel->position.y = SCALAR(positionY);
+    newModel->position.z = SCALAR(-positionZ);
+    newModel->scale.x = SCALAR(0.01F);
+    newModel->scale.y = SCALAR(0.01F);
+    newModel->scale.z = SCALAR(0.01F);
+    newModel->rotationAxis.x = SCALAR(rotX);
+    newModel->rotationAxis.y = SCALAR(rotY);
+    newModel->rotationAxis.z = SCALAR(-rotZ);
+    newModel->rotationAngle = SCALAR(-angle);
 
     return newModel;
 }
 
-void modelDraw(actor *model, Gfx **displayList)
+static int sameVector(vector3 a, vector3 b)
 {
-    if (!model->visible) return;
-
-    guTranslate(&model->transform.translation, model->position.x,
-        model->position.y, model->position.z);
-
-    guRotate(&model->transform.rotation, model->rotationAngle,
-        model->rotationAxis.x, model->rotationAxis.y, model->rotationAxis.z);
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
 
-    guScale(&model->transform.scale, model->scale.x,
-        model->scale.y, model->scale.z);
+static vector3 blendVector(vector3 from, vector3 to, scalar amount)
+{
+    return vec3_add(from, vec3_mul(vec3_sub(to, from), amount));
+}
 
-    gSPMatrix((*displayList)++, OS_K0_TO_PHYSICAL(&model->transform.translation),
-        G_MTX_MODELVIEW | G_MTX_MUL | G_MTX_PUSH);
+actorPose blendActorPose(actor *target, float blend)
+{
+    const transformState *state = &actorStates[ACTOR_SLOT(target)];
+    const actorPose *previous = &state->previous;
+    actorPose pose = { target->position, target->rotationAxis, target->scale, target->rotationAngle };
+    scalar amount;
 
-    gSPMatrix((*displayList)++, OS_K0_TO_PHYSICAL(&model->transform.rotation),
-        G_MTX_MODELVIEW | G_MTX_MUL | G_MTX_NOPUSH);
+    if (!state->posed || blend >= 1) return pose;
 
-    gSPMatrix((*displayList)++, OS_K0_TO_PHYSICAL(&model->transform.scale),
-        G_MTX_MODELVIEW | G_MTX_MUL | G_MTX_NOPUSH);
+    amount = SCALAR(blend);
+    pose.position = blendVector(previous->position, pose.position, amount);
+    pose.scale = blendVector(previous->scale, pose.scale, amount);
 
-    gDPPipeSync((*displayList)++);
+    // Angles only blend about an unchanged axis, since mixing two axes swings through neither rotation.
+    if (sameVector(previous->rotationAxis, pose.rotationAxis))
+    {
+        pose.rotationAngle = previous->rotationAngle + scalar_mul(pose.rotationAngle - previous->rotationAngle, amount);
+    }
 
-    gDPSetCycleType((*displayList)++, G_CYC_1CYCLE);
-    gDPSetRenderMode((*displayList)++, G_RM_AA_ZB_OPA_SURF, G_RM_AA_ZB_OPA_SURF2);
-    gSPClearGeometryMode((*displayList)++, 0xFFFFFFFF);
-    gSPSetGeometryMode((*displayList)++, G_SHADE | G_SHADING_SMOOTH | G_ZBUFFER | G_CULL_FRONT);
+    return pose;
+}
 
-    if (model->texture != NULL)
+void updateTransform(actor *target, int buffer, float blend)
+{
+    const int slot = ACTOR_SLOT(target);
+    transformState *last = &actorStates[slot];
+    transform *matrices = &actorTransforms[slot];
+    const actorPose pose = blendActorPose(target, blend);
+    const actorPose *composed = &last->composed;
+
+    // Scripts write the transform fields directly so compare against what was last composed.
+    if (!last->dirty && sameVector(pose.position, composed->position) && sameVector(pose.scale, composed->scale)
+        && sameVector(pose.rotationAxis, composed->rotationAxis) && pose.rotationAngle == composed->rotationAngle)
     {
-        gSPTexture((*displayList)++, 0xffff, 0xffff, 0, G_TX_RENDERTILE, G_ON);
-        gDPSetTextureFilter((*displayList)++, G_TF_BILERP);
-        gDPSetTexturePersp((*displayList)++, G_TP_PERSP);
-        gDPSetCombineMode((*displayList)++, G_CC_MODULATERGB, G_CC_MODULATERGB);
-        gDPLoadTextureBlock((*displayList)++, model->texture, G_IM_FMT_RGBA, G_IM_SIZ_16b, 
-            model->textureWidth, model->textureHeight, 0,
-            G_TX_WRAP, G_TX_WRAP, G_TX_NOMASK, G_TX_NOMASK, G_TX_NOLOD, G_TX_NOLOD);
+        // This buffer missed the last change so copy the matrix from one that didn't.
+        for (int i = 0; i < GFX_BUFFER_COUNT && (last->staleBuffers & (1 << buffer)); i++)
+        {
+            if (last->staleBuffers & (1 << i)) continue;
+
+            matrices->model[buffer] = matrices->model[i];
+            last->staleBuffers &= ~(1 << buffer);
+        }
+        return;
     }
-    else
+
+    float rotation[4][4], model[4][4];
+    float scale[3] = {
+        SCALAR_TO_FLOAT(pose.scale.x), SCALAR_TO_FLOAT(pose.scale.y), SCALAR_TO_FLOAT(pose.scale.z)
+    };
+
+    guRotateF(rotation, SCALAR_TO_FLOAT(pose.rotationAngle), SCALAR_TO_FLOAT(pose.rotationAxis.x),
+        SCALAR_TO_FLOAT(pose.rotationAxis.y), SCALAR_TO_FLOAT(pose.rotationAxis.z));
+
+    // Scale, rotate then translate in one matrix so drawing needs a single load instead of three multiplies.
+    for (int i = 0; i < 3; i++)
     {
-        gDPSetCombineMode((*displayList)++, G_CC_SHADE, G_CC_SHADE);
+        for (int j = 0; j < 4; j++)
+        {
+            model[i][j] = rotation[i][j] * scale[i];
+        }
     }
 
-    int skip = 0;
-    int remainingVertices = model->mesh.vertexCount;
-    const int size = 30;
+    model[3][0] = SCALAR_TO_FLOAT(pose.position.x);
+    model[3][1] = SCALAR_TO_FLOAT(pose.position.y);
+    model[3][2] = SCALAR_TO_FLOAT(pose.position.z);
+    model[3][3] = 1;
+    guMtxF2L(model, &matrices->model[buffer]);
 
-    // Send vertex data in batches.
-    while (remainingVertices > 0)
+    // Keep the bounding sphere in world space for culling.
+    if (target->type == Model)
     {
-        int take = remainingVertices >= size ? size : remainingVertices;
-        gSPVertex((*displayList)++, &(model->mesh.vertices[skip]), take, 0);
-        gDPPipeSync((*displayList)++);
+        const mesh *source = &actorModels[slot].mesh;
+        sphereBounds *bounds = &actorBounds[slot];
+        vec3f center = source->boundsCenter;
+        float largestScale = 0;
 
-        for (int i = 0; i < take / 3; i++)
+        for (int i = 0; i < 3; i++)
         {
-            gSP1Triangle((*displayList)++, i * 3, i * 3 + 1, i * 3 + 2, 0);
+            float size = scale[i] < 0 ? -scale[i] : scale[i];
+            if (size > largestScale) largestScale = size;
         }
 
-        remainingVertices -= take;
-        skip += take;
+        bounds->center.x = center.x * model[0][0] + center.y * model[1][0] + center.z * model[2][0] + model[3][0];
+        bounds->center.y = center.x * model[0][1] + center.y * model[1][1] + center.z * model[2][1] + model[3][1];
+        bounds->center.z = center.x * model[0][2] + center.y * model[1][2] + center.z * model[2][2] + model[3][2];
+        bounds->radius = source->boundsRadius * largestScale;
     }
 
-    gSPPopMatrix((*displayList)++, G_MTX_MODELVIEW);
+    last->composed = pose;
+    last->dirty = 0;
+    last->staleBuffers = ((1 << GFX_BUFFER_COUNT) - 1) & ~(1 << buffer);
 }
 
-actor *createCamera(double positionX, double positionY, double positionZ,
-    double rotX, double rotY, double rotZ, double angle, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider)
+actor *createCamera(float positionX, float positionY, float positionZ,
+    float rotX, float rotY, float rotZ, float angle, 
+    float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider)
 {
-    actor *camera = (actor*)malloc(sizeof(actor));
+    actor *camera = allocActor(0);
+    if (camera == NULL) return NULL;
+
     camera->visible = 1;
     camera->type = Camera;
     camera->collider = collider;
+    camera->collide = NULL;
 
-    camera->center.x = centerX;
-    camera->center.y = centerY;
-    camera->center.z = centerZ;
-    camera->radius = radius;
+    camera->center.x = SCALAR(centerX);
+    camera->center.y = SCALAR(centerY);
+    camera->center.z = SCALAR(centerZ);
+    camera->radius = SCALAR(radius);
 
-    camera->extents.x = extentX;
-    camera->extents.y = extentY;
-    camera->extents.z = extentZ;
+    camera->extents.x = SCALAR(extentX);
+    camera->extents.y = SCALAR(extentY);
+    camera->extents.z = SCALAR(extentZ);
 
     if (rotX == 0.0 && rotY == 0.0 && rotZ == 0.0) rotZ = 1;
-    camera->position.x = positionX;
-    camera->position.y = positionY;
-    camera->position.z = positionZ;
-    camera->rotationAxis.x = rotX;
-    camera->rotationAxis.y = rotY;
-    camera->rotationAxis.z = rotZ;
-    camera->rotationAngle = angle;
+    camera->position.x = SCALAR(positionX);
+    camera->position.y = SCALAR(positionY);
+    camera->position.z = SCALAR(positionZ);
+    camera->rotationAxis.x = SCALAR(rotX);
+    camera->rotationAxis.y = SCALAR(rotY);
+    camera->rotationAxis.z = SCALAR(rotZ);
+    camera->rotationAngle = SCALAR(angle);
 
     return camera;
 }
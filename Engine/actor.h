@@ -2,67 +2,136 @@
 #define _ACTOR_H_
 
 #include <nusys.h>
+#include "vecmath.h"
 
 enum actorType { Model, Camera };
 
 enum colliderType { None, Sphere, Box };
 
+// Frame data the RCP reads is kept once per display list so the CPU can build one while the other draws.
+#define GFX_BUFFER_COUNT 2
+
 typedef struct transform 
 {
-    Mtx projection;
-    Mtx translation;
-    Mtx scale;
-    Mtx rotation;
+    Mtx model[GFX_BUFFER_COUNT];
 } transform;
 
-typedef struct vector3
+// Placement of an actor, as scripts write it into the actor's own fields.
+typedef struct actorPose
+{
+    vector3 position;
+    vector3 rotationAxis;
+    vector3 scale;
+    scalar rotationAngle;
+} actorPose;
+
+// Pose the transform matrices were last composed from, and which buffers still hold an older matrix.
+// Previous is the pose at the start of the current simulation step, which drawing blends from.
+typedef struct transformState
 {
-    double x, y, z;
-} vector3;
+    actorPose composed;
+    actorPose previous;
+    u8 dirty;
+    u8 staleBuffers;
+    u8 posed;
+} transformState;
 
+// Segment numbers the editor stores in the top byte of addresses inside baked display lists.
+#define MESH_SEGMENT 1
+#define TEXTURE_SEGMENT 2
+
+// Levels of detail a mesh segment can hold.
+#define MESH_MAX_LODS 3
+
+typedef struct meshHeader
+{
+    u32 stateOffset;
+    u32 textureLoadOffset;
+    u32 stateKey;
+    u32 relocationOffset;
+    u32 relocationCount;
+    f32 boundsCenter[3];
+    f32 boundsRadius;
+    u32 lodCount;
+    u32 geometryOffset[MESH_MAX_LODS];
+    u32 tiled;
+    u32 reserved[2];
+} meshHeader;
+
+// Display lists baked by the editor. Meshes with the same state key set up the RDP identically.
+// Bounds are in vertex units, before the actor's transform. Tiled meshes load each texture tile from their
+// geometry lists, leaving only an indexed texture's palette to the texture load list.
 typedef struct mesh
 {
-    int vertexCount;
-    Vtx *vertices;
+    Gfx *state;
+    Gfx *textureLoad;
+    Gfx *geometry[MESH_MAX_LODS];
+    int lodCount;
+    u32 stateKey;
+    vec3f boundsCenter;
+    float boundsRadius;
+    int tiled;
 } mesh;
 
-typedef struct actor 
+// World space bounding sphere, kept current with the model matrix for culling.
+typedef struct sphereBounds
+{
+    vec3f center;
+    float radius;
+} sphereBounds;
+
+// Everything drawing needs past the transform, only read for actors that survive culling.
+typedef struct actorModel
 {
-    enum actorType type;
-    enum colliderType collider;
     mesh mesh;
     unsigned short *texture;
     int textureWidth;
     int textureHeight;
-    double rotationAngle;
-    double radius;
+    float lodDistances[MESH_MAX_LODS - 1];
+    int lod;
+} actorModel;
+
+// The fields scripts read and write. The engine keeps the rest of an actor in the pool's parallel
+// arrays, so this stays small enough for the per-frame loops to walk without thrashing the data cache.
+typedef struct actor 
+{
+    enum actorType type;
+    enum colliderType collider;
     int visible;
     vector3 position;
     vector3 rotationAxis;
+    scalar rotationAngle;
     vector3 scale;
     vector3 center;
     vector3 extents;
-    transform transform;
+    scalar radius;
+    void (*collide)(struct actor *self, struct actor *other);
 } actor;
 
-actor *loadModel(void *dataStart, void *dataEnd, double positionX, double positionY, double positionZ,
-    double rotX, double rotY, double rotZ, double angle, double scaleX, double scaleY, double scaleZ, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider);
+actor *loadModel(void *dataStart, void *dataEnd, float positionX, float positionY, float positionZ,
+    float rotX, float rotY, float rotZ, float angle, float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider,
+    float lodDistance1, float lodDistance2);
 
 actor *loadTexturedModel(void *dataStart, void *dataEnd,
     void *textureStart, void *textureEnd, int textureWidth, int textureHeight,
-    double positionX, double positionY, double positionZ,
-    double rotX, double rotY, double rotZ, double angle,
-    double scaleX, double scaleY, double scaleZ, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider);
-
-actor *createCamera(double positionX, double positionY, double positionZ,
-    double rotX, double rotY, double rotZ, double angle, 
-    double centerX, double centerY, double centerZ, double radius,
-    double extentX, double extentY, double extentZ, enum colliderType collider);
-
-void modelDraw(actor *model, Gfx **displayList);
+    float positionX, float positionY, float positionZ,
+    float rotX, float rotY, float rotZ, float angle,
+    float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider,
+    float lodDistance1, float lodDistance2);
+
+actor *createCamera(float positionX, float positionY, float positionZ,
+    float rotX, float rotY, float rotZ, float angle, 
+    float centerX, float centerY, float centerZ, float radius,
+    float extentX, float extentY, float extentZ, enum colliderType collider);
+
+// Pose between the start of the current simulation step and now, with a blend of 0 being the start.
+actorPose blendActorPose(actor *target, float blend);
+
+void updateTransform(actor *target, int buffer, float blend);
+
+// Models are queued to load in the background and aren't drawn until their mesh has arrived.
+int isActorLoaded(actor *target);
 
 #endif
@@ -1,142 +1,287 @@
+#include <malloc.h>
 #include "utilities.h"
 #include "collision.h"
+#include "pool.h"
 
-int check_collision(actor *a, actor *b)
+typedef struct sweepEntry
+{
+    actor *body;
+    colliderFrame *frame;
+    vector3 min;
+    vector3 max;
+} sweepEntry;
+static sweepEntry *entries = NULL;
+static sweepEntry *scratch = NULL;
+static colliderFrame *frames = NULL;
+static int entryCapacity = 0;
+
+// Each slot's collider rotation, built from the pose the simulation is at rather than the blended pose
+// drawing last composed, and only rebuilt when the axis or angle changes.
+typedef struct colliderRotation
+{
+    vector3 axis;
+    scalar angle;
+    matrix3 rotation;
+    u8 built;
+} colliderRotation;
+static colliderRotation rotations[ACTOR_POOL_CAPACITY];
+
+// Bottom-up merge sort on the low x edge of each collider's bounds.
+static void sortEntries(int count)
+{
+    for (int width = 1; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += width * 2)
+        {
+            int middle = start + width < count ? start + width : count;
+            int end = start + width * 2 < count ? start + width * 2 : count;
+            int left = start, right = middle, out = start;
+
+            while (left < middle && right < end)
+                scratch[out++] = entries[left].min.x <= entries[right].min.x ? entries[left++] : entries[right++];
+
+            while (left < middle) scratch[out++] = entries[left++];
+            while (right < end) scratch[out++] = entries[right++];
+        }
+
+        sweepEntry *sorted = scratch;
+        scratch = entries;
+        entries = sorted;
+    }
+}
+
+static int reserveEntries(int count)
+{
+    if (count <= entryCapacity) return 1;
+
+    free(entries);
+    free(scratch);
+    free(frames);
+    entries = (sweepEntry*)malloc(sizeof(sweepEntry) * count);
+    scratch = (sweepEntry*)malloc(sizeof(sweepEntry) * count);
+    frames = (colliderFrame*)malloc(sizeof(colliderFrame) * count);
+    entryCapacity = entries != NULL && scratch != NULL && frames != NULL ? count : 0;
+
+    return entryCapacity > 0;
+}
+
+void collide_actors(vector actors)
+{
+    const int actorCount = vector_size(actors);
+    int count = 0, handlers = 0;
+
+    for (int i = 0; i < actorCount; i++)
+    {
+        actor *body = vector_get(actors, i);
+        if (isActorAlive(body) && body->collider != None && body->collide != NULL) handlers++;
+    }
+
+    // Nothing would be told about a hit so there's no point looking for any.
+    if (handlers == 0 || !reserveEntries(actorCount)) return;
+
+    for (int i = 0; i < actorCount; i++)
+    {
+        actor *body = vector_get(actors, i);
+
+        if (!isActorAlive(body) || body->collider == None) continue;
+
+        // Each collider's world frame is worked out once here and shared by every pair it's tested in.
+        sweepEntry *entry = &entries[count];
+        entry->body = body;
+        entry->frame = &frames[count++];
+        get_collider_frame(body, entry->frame);
+
+        const scalar reach = entry->frame->radius;
+        entry->min = vec3_sub(entry->frame->center, (vector3) { reach, reach, reach });
+        entry->max = vec3_add(entry->frame->center, (vector3) { reach, reach, reach });
+    }
+
+    sortEntries(count);
+
+    // Sweep along x and only run the narrow phase on pairs whose bounds also overlap on y and z.
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = i + 1; j < count && entries[j].min.x <= entries[i].max.x; j++)
+        {
+            if (entries[i].max.y < entries[j].min.y || entries[j].max.y < entries[i].min.y) continue;
+            if (entries[i].max.z < entries[j].min.z || entries[j].max.z < entries[i].min.z) continue;
+            if (entries[i].body->collide == NULL && entries[j].body->collide == NULL) continue;
+
+            // Callbacks can destroy either actor part way through the sweep.
+            if (!isActorAlive(entries[i].body) || !isActorAlive(entries[j].body)) continue;
+
+            if (check_frames(entries[i].frame, entries[j].frame))
+            {
+                if (entries[j].body->collide) entries[j].body->collide(entries[j].body, entries[i].body);
+                if (entries[i].body->collide) entries[i].body->collide(entries[i].body, entries[j].body);
+            }
+        }
+    }
+}
+
+static const matrix3 *get_collider_rotation(actor *body)
+{
+    colliderRotation *cached = &rotations[ACTOR_SLOT(body)];
+    float rotation[4][4];
+
+    if (cached->built && cached->angle == body->rotationAngle && cached->axis.x == body->rotationAxis.x
+        && cached->axis.y == body->rotationAxis.y && cached->axis.z == body->rotationAxis.z) return &cached->rotation;
+
+    guRotateF(rotation, SCALAR_TO_FLOAT(body->rotationAngle), SCALAR_TO_FLOAT(body->rotationAxis.x),
+        SCALAR_TO_FLOAT(body->rotationAxis.y), SCALAR_TO_FLOAT(body->rotationAxis.z));
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            cached->rotation.m[i][j] = SCALAR(rotation[i][j]);
+
+    cached->axis = body->rotationAxis;
+    cached->angle = body->rotationAngle;
+    cached->built = 1;
+    return &cached->rotation;
+}
+
+void get_collider_frame(actor *body, colliderFrame *frame)
 {
-    if (a->collider == Sphere && b->collider == Sphere)
-        return sphere_sphere_collision(a, b);
-    else if (a->collider == Box && b->collider == Sphere)
+    const matrix3 *rotation = get_collider_rotation(body);
+
+    frame->type = body->collider;
+    frame->center = vec3_add(body->position, vec3_mul_mat3(body->center, rotation));
+    frame->extents = body->extents;
+    frame->radius = body->collider == Box ? vec3_len(body->extents, body->extents) : body->radius;
+
+    for (int i = 0; i < 3; i++)
+        frame->axes[i] = (vector3) { rotation->m[i][0], rotation->m[i][1], rotation->m[i][2] };
+}
+
+int check_frames(colliderFrame *a, colliderFrame *b)
+{
+    if (a->type == None || b->type == None) return 0;
+
+    // Bounding spheres settle most pairs before the box tests, and are exact for two spheres.
+    if (!sphere_sphere_collision(a, b)) return 0;
+
+    if (a->type == Box && b->type == Sphere)
         return box_sphere_collision(a, b);
-    else if (a->collider == Sphere && b->collider == Box)
+    else if (a->type == Sphere && b->type == Box)
         return box_sphere_collision(b, a);
-    else if (a->collider == Box && b->collider == Box)
+    else if (a->type == Box && b->type == Box)
         return box_box_collision(a, b);
-    
-    return 0;
+
+    return 1;
 }
 
-int sphere_sphere_collision(actor *a, actor *b)
+int check_collision(actor *a, actor *b)
 {
-    const float radiusSum = a->radius + b->radius;
-    vector3 aPos = vec3_add(a->position, vec3_mul_mat3x3(a->center, a->transform.rotation));
-    vector3 bPos = vec3_add(b->position, vec3_mul_mat3x3(b->center, b->transform.rotation));
-    vector3 dist = vec3_sub(aPos, bPos);
+    colliderFrame aFrame, bFrame;
 
-    return vec3_dot(dist, dist) <= radiusSum * radiusSum;
+    get_collider_frame(a, &aFrame);
+    get_collider_frame(b, &bFrame);
+    return check_frames(&aFrame, &bFrame);
 }
 
-int box_box_collision(actor *a, actor *b)
+int sphere_sphere_collision(colliderFrame *a, colliderFrame *b)
 {
-    vector3 aPos = vec3_add(a->position, vec3_mul_mat3x3(a->center, a->transform.rotation));
-    vector3 bPos = vec3_add(b->position, vec3_mul_mat3x3(b->center, b->transform.rotation));
-    
-    vector3 aAxis[3] = { 
-        vec3_mul_mat3x3((vector3) { 1, 0, 0 }, a->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 1, 0 }, a->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 0, 1 }, a->transform.rotation)
-    };
+    const scalar radiusSum = a->radius + b->radius;
+    vector3 dist = vec3_sub(a->center, b->center);
 
-    float aExt[3] = { a->extents.x, a->extents.y, a->extents.z };
-
-    vector3 bAxis[3] = {
-        vec3_mul_mat3x3((vector3) { 1, 0, 0 }, b->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 1, 0 }, b->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 0, 1 }, b->transform.rotation)
-    };
+    return vec3_dot(dist, dist) <= scalar_mul(radiusSum, radiusSum);
+}
 
-    float bExt[3] = { b->extents.x, b->extents.y, b->extents.z };
+int box_box_collision(colliderFrame *a, colliderFrame *b)
+{
+    vector3 aPos = a->center;
+    vector3 bPos = b->center;
+    vector3 *aAxis = a->axes;
+    vector3 *bAxis = b->axes;
+    scalar aExt[3] = { a->extents.x, a->extents.y, a->extents.z };
+    scalar bExt[3] = { b->extents.x, b->extents.y, b->extents.z };
 
-    float ra, rb;
-    float R[3][3], AbsR[3][3];
-    const float EPSILON = 0.0001;
+    scalar ra, rb;
+    scalar R[3][3], AbsR[3][3];
+    const scalar EPSILON = SCALAR(0.0001F);
 
     for (int i = 0; i < 3; i++)
         for (int j = 0; j < 3; j++)
             R[i][j] = vec3_dot(aAxis[i], bAxis[j]);
 
     vector3 t = vec3_sub(bPos, aPos);
-    float ta[3] = { vec3_dot(t, aAxis[0]), vec3_dot(t, aAxis[1]), vec3_dot(t, aAxis[2]) };
+    scalar ta[3] = { vec3_dot(t, aAxis[0]), vec3_dot(t, aAxis[1]), vec3_dot(t, aAxis[2]) };
 
     for (int i = 0; i < 3; i++)
         for (int j = 0; j < 3; j++)
-            AbsR[i][j] = fabs(R[i][j]) + EPSILON;
+            AbsR[i][j] = scalar_abs(R[i][j]) + EPSILON;
 
     for (int i = 0; i < 3; i++)
     {
         ra = aExt[i];
-        rb = bExt[0] * AbsR[i][0] + bExt[1] * AbsR[i][1] + bExt[2] * AbsR[i][2];
-        if (fabs(ta[i]) > ra + rb) return 0;
+        rb = scalar_mul(bExt[0], AbsR[i][0]) + scalar_mul(bExt[1], AbsR[i][1]) + scalar_mul(bExt[2], AbsR[i][2]);
+        if (scalar_abs(ta[i]) > ra + rb) return 0;
     }
 
     for (int i = 0; i < 3; i++)
     {
-        ra = aExt[0] * AbsR[0][i] + aExt[1] * AbsR[1][i] + aExt[2] * AbsR[2][i];
+        ra = scalar_mul(aExt[0], AbsR[0][i]) + scalar_mul(aExt[1], AbsR[1][i]) + scalar_mul(aExt[2], AbsR[2][i]);
         rb = bExt[i];
-        if (fabs(ta[0] * R[0][i] + ta[1] * R[1][i] + ta[2] * R[2][i]) > ra + rb) return 0;
+        if (scalar_abs(scalar_mul(ta[0], R[0][i]) + scalar_mul(ta[1], R[1][i]) + scalar_mul(ta[2], R[2][i]))
+            > ra + rb) return 0;
     }
 
-    ra = aExt[1] * AbsR[2][0] + aExt[2] * AbsR[1][0];
-    rb = bExt[1] * AbsR[0][2] + bExt[2] * AbsR[0][1];
-    if (fabs(ta[2] * R[1][0] - ta[1] * R[2][0]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[1], AbsR[2][0]) + scalar_mul(aExt[2], AbsR[1][0]);
+    rb = scalar_mul(bExt[1], AbsR[0][2]) + scalar_mul(bExt[2], AbsR[0][1]);
+    if (scalar_abs(scalar_mul(ta[2], R[1][0]) - scalar_mul(ta[1], R[2][0])) > ra + rb) return 0;
 
-    ra = aExt[1] * AbsR[2][1] + aExt[2] * AbsR[1][1];
-    rb = bExt[0] * AbsR[0][2] + bExt[2] * AbsR[0][0];
-    if (fabs(ta[2] * R[1][1] - ta[1] * R[2][1]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[1], AbsR[2][1]) + scalar_mul(aExt[2], AbsR[1][1]);
+    rb = scalar_mul(bExt[0], AbsR[0][2]) + scalar_mul(bExt[2], AbsR[0][0]);
+    if (scalar_abs(scalar_mul(ta[2], R[1][1]) - scalar_mul(ta[1], R[2][1])) > ra + rb) return 0;
 
-    ra = aExt[1] * AbsR[2][2] + aExt[2] * AbsR[1][2];
-    rb = bExt[0] * AbsR[0][1] + bExt[1] * AbsR[0][0];
-    if (fabs(ta[2] * R[1][2] - ta[1] * R[2][2]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[1], AbsR[2][2]) + scalar_mul(aExt[2], AbsR[1][2]);
+    rb = scalar_mul(bExt[0], AbsR[0][1]) + scalar_mul(bExt[1], AbsR[0][0]);
+    if (scalar_abs(scalar_mul(ta[2], R[1][2]) - scalar_mul(ta[1], R[2][2])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[2][0] + aExt[2] * AbsR[0][0];
-    rb = bExt[1] * AbsR[1][2] + bExt[2] * AbsR[1][1];
-    if (fabs(ta[0] * R[2][0] - ta[2] * R[0][0]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[2][0]) + scalar_mul(aExt[2], AbsR[0][0]);
+    rb = scalar_mul(bExt[1], AbsR[1][2]) + scalar_mul(bExt[2], AbsR[1][1]);
+    if (scalar_abs(scalar_mul(ta[0], R[2][0]) - scalar_mul(ta[2], R[0][0])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[2][1] + aExt[2] * AbsR[0][1];
-    rb = bExt[0] * AbsR[1][2] + bExt[2] * AbsR[1][0];
-    if (fabs(ta[0] * R[2][1] - ta[2] * R[0][1]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[2][1]) + scalar_mul(aExt[2], AbsR[0][1]);
+    rb = scalar_mul(bExt[0], AbsR[1][2]) + scalar_mul(bExt[2], AbsR[1][0]);
+    if (scalar_abs(scalar_mul(ta[0], R[2][1]) - scalar_mul(ta[2], R[0][1])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[2][2] + aExt[2] * AbsR[0][2];
-    rb = bExt[0] * AbsR[1][1] + bExt[1] * AbsR[1][0];
-    if (fabs(ta[0] * R[2][2] - ta[2] * R[0][2]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[2][2]) + scalar_mul(aExt[2], AbsR[0][2]);
+    rb = scalar_mul(bExt[0], AbsR[1][1]) + scalar_mul(bExt[1], AbsR[1][0]);
+    if (scalar_abs(scalar_mul(ta[0], R[2][2]) - scalar_mul(ta[2], R[0][2])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[1][0] + aExt[1] * AbsR[0][0];
-    rb = bExt[1] * AbsR[2][2] + bExt[2] * AbsR[2][1];
-    if (fabs(ta[1] * R[0][0] - ta[0] * R[1][0]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[1][0]) + scalar_mul(aExt[1], AbsR[0][0]);
+    rb = scalar_mul(bExt[1], AbsR[2][2]) + scalar_mul(bExt[2], AbsR[2][1]);
+    if (scalar_abs(scalar_mul(ta[1], R[0][0]) - scalar_mul(ta[0], R[1][0])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[1][1] + aExt[1] * AbsR[0][1];
-    rb = bExt[0] * AbsR[2][2] + bExt[2] * AbsR[2][0];
-    if (fabs(ta[1] * R[0][1] - ta[0] * R[1][1]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[1][1]) + scalar_mul(aExt[1], AbsR[0][1]);
+    rb = scalar_mul(bExt[0], AbsR[2][2]) + scalar_mul(bExt[2], AbsR[2][0]);
+    if (scalar_abs(scalar_mul(ta[1], R[0][1]) - scalar_mul(ta[0], R[1][1])) > ra + rb) return 0;
 
-    ra = aExt[0] * AbsR[1][2] + aExt[1] * AbsR[0][2];
-    rb = bExt[0] * AbsR[2][1] + bExt[1] * AbsR[2][0];
-    if (fabs(ta[1] * R[0][2] - ta[0] * R[1][2]) > ra + rb) return 0;
+    ra = scalar_mul(aExt[0], AbsR[1][2]) + scalar_mul(aExt[1], AbsR[0][2]);
+    rb = scalar_mul(bExt[0], AbsR[2][1]) + scalar_mul(bExt[1], AbsR[2][0]);
+    if (scalar_abs(scalar_mul(ta[1], R[0][2]) - scalar_mul(ta[0], R[1][2])) > ra + rb) return 0;
 
     return 1;
 }
 
-int box_sphere_collision(actor *a, actor *b)
+int box_sphere_collision(colliderFrame *a, colliderFrame *b)
 {
-    vector3 aPos = vec3_add(a->position, vec3_mul_mat3x3(a->center, a->transform.rotation));
-    vector3 bPos = vec3_add(b->position, vec3_mul_mat3x3(b->center, b->transform.rotation));
-
-    vector3 aAxis[3] = {
-        vec3_mul_mat3x3((vector3) { 1, 0, 0 }, a->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 1, 0 }, a->transform.rotation),
-        vec3_mul_mat3x3((vector3) { 0, 0, 1 }, a->transform.rotation)
-    };
-
-    float aExt[3] = { a->extents.x, a->extents.y, a->extents.z };
+    vector3 aPos = a->center;
+    vector3 bPos = b->center;
+    vector3 *aAxis = a->axes;
+    scalar aExt[3] = { a->extents.x, a->extents.y, a->extents.z };
 
     vector3 abDir = vec3_sub(bPos, aPos);
     vector3 closestPoint = aPos;
     for (int i = 0; i < 3; i++)
     {
-        float dist = vec3_dot(abDir, aAxis[i]);
+        scalar dist = vec3_dot(abDir, aAxis[i]);
         if (dist > aExt[i]) dist = aExt[i];
         if (dist < -aExt[i]) dist = -aExt[i];
         closestPoint = vec3_add(closestPoint, vec3_mul(aAxis[i], dist));
     }
 
     vector3 closestDir = vec3_sub(closestPoint, bPos);
-    return vec3_dot(closestDir, closestDir) <= b->radius * b->radius;
+    return vec3_dot(closestDir, closestDir) <= scalar_mul(b->radius, b->radius);
 }
@@ -2,13 +2,33 @@
 #define _COLLISION_H_
 
 #include "actor.h"
+#include "vector.h"
+
+// A collider placed in the world: its center, the directions its box extents run along and
+// the radius of a sphere around it, which is the collider itself for spheres.
+typedef struct colliderFrame
+{
+    enum colliderType type;
+    vector3 center;
+    vector3 axes[3];
+    vector3 extents;
+    scalar radius;
+} colliderFrame;
+
+// Tests every pair of actors that have a collider and at least one collide callback between them, and calls
+// whichever callbacks they have on a hit.
+void collide_actors(vector actors);
 
 int check_collision(actor *a, actor *b);
 
-int sphere_sphere_collision(actor *a, actor *b);
+void get_collider_frame(actor *body, colliderFrame *frame);
+
+int check_frames(colliderFrame *a, colliderFrame *b);
+
+int sphere_sphere_collision(colliderFrame *a, colliderFrame *b);
 
-int box_box_collision(actor *a, actor *b);
+int box_box_collision(colliderFrame *a, colliderFrame *b);
 
-int box_sphere_collision(actor *a, actor *b);
+int box_sphere_collision(colliderFrame *a, colliderFrame *b);
 
 #endif
@@ -1,21 +1,39 @@
 #ifndef _CORE_H_
 #define _CORE_H_
 
+#include <malloc.h>
+#include "n64sdk\ultra\GCC\MIPSE\INCLUDE\STRING.H"
 #include "actor.h"
-#include "hashtable.h"
+#include "pool.h"
+#include "loader.h"
 
-#define VECTOR3(X, Y, Z) (vector3) { X, Y, Z }
+#define VECTOR3(X, Y, Z) (vector3) { SCALAR(X), SCALAR(Y), SCALAR(Z) }
 
+// Seeded FNV-1a, the same hash the editor lays the generated name table out with.
+unsigned int name_hash(const char *s, unsigned int seed)
+{
+    unsigned int hashval = 2166136261u ^ seed;
+    for (; *s != '\0'; s++)
+    {
+        hashval = (hashval ^ (unsigned char)*s) * 16777619u;
+    }
+    return hashval;
+}
+
+// Only scene actors have names, and those are all placed in the table at build time.
 actor *FindActorByName(const char *name)
 {
-    nlist *np = lookup(name);
-    if (np == NULL) return NULL;
-    return vector_get(_UER_Actors, np->gameObjectIndex);
+    unsigned int bucket = name_hash(name, 0) % _UER_NAME_BUCKETS;
+    unsigned int slot = name_hash(name, _UER_NameSeeds[bucket]) % _UER_NAME_SLOTS;
+    if (_UER_NameKeys[slot] != NULL && strcmp(name, _UER_NameKeys[slot]) == 0)
+        return vector_get(_UER_Actors, _UER_NameActors[slot]);
+
+    return NULL;
 }
 
 void SetActiveCamera(actor *camera)
 {
-    if (camera != NULL && camera->type == Camera)
+    if (isActorAlive(camera) && camera->type == Camera)
     {
         _UER_ActiveCamera = camera;
     }
@@ -25,17 +43,37 @@ actor *Instantiate(actor *other)
 {
     if (other == NULL) return NULL;
 
-    actor *clonedActor = (actor *)malloc(sizeof(actor));
-    if (clonedActor)
-    {
-        memcpy(clonedActor, other, sizeof(*clonedActor));
+    // A clone only copies display lists the original already has, so wait for them to arrive.
+    if (!isActorLoaded(other)) finishLoads();
 
-        vector_add(_UER_Actors, clonedActor);
+    return spawnActor(_UER_Actors, other);
+}
 
-        return clonedActor;
-    }
+void Destroy(actor *target)
+{
+    destroyActor(target);
+}
 
-    return NULL;
+actorHandle GetHandle(actor *target)
+{
+    return getActorHandle(target);
+}
+
+// Returns NULL once the actor the handle was taken from has been destroyed.
+actor *GetActor(actorHandle handle)
+{
+    return resolveActorHandle(handle);
+}
+
+// Scene models stream in over the first frames and are drawn as each one arrives.
+int IsLoaded(actor *target)
+{
+    return target != NULL && isActorLoaded(target);
+}
+
+int LoadsPending()
+{
+    return loadsPending();
 }
 
 #endif
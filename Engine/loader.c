@@ -0,0 +1,287 @@
+#include <malloc.h>
+#include "loader.h"
+#include "unpack.h"
+
+// Written by the editor at the start of every segment. Packed size is zero for segments stored as-is.
+typedef struct segmentHeader
+{
+    u32 size;
+    u32 packedSize;
+} segmentHeader;
+
+enum segmentState
+{
+    ReadingHeader,
+    ReadingData,
+    Ready,
+    Failed
+};
+
+typedef struct segment
+{
+    void *romStart;
+    enum segmentState state;
+    u8 *data;
+    u8 *packed;
+    void *dataBlock;
+    void *packedBlock;
+    int size;
+    int romSize;
+    int requested;
+    struct segment *next;
+} segment;
+
+typedef struct loadJob
+{
+    segment *source;
+    segmentLoaded loaded;
+    void *target;
+    int first;
+    struct loadJob *next;
+} loadJob;
+
+static segment *segments = NULL;
+static segment *lastSegment = NULL;
+static segment *reading = NULL;
+static segment *transferring = NULL;
+static loadJob *jobHead = NULL;
+static loadJob *jobTail = NULL;
+
+static OSMesgQueue dmaQueue;
+static OSMesg dmaMessages[1];
+static OSIoMesg dmaRequest;
+static int queueCreated = 0;
+
+// Headers get a whole cache line to themselves so invalidating it can't throw away anything else.
+static u64 headerBuffer[2] __attribute__((aligned(16)));
+
+static int lineSize(int size)
+{
+    return (size + DCACHE_LINESIZE - 1) & ~(DCACHE_LINESIZE - 1);
+}
+
+// DMA destinations start on a data cache line and cover whole lines, so no other allocation can share a line
+// that gets invalidated or have one of its dirty lines written back over the transfer.
+static u8 *allocLines(int size, void **block)
+{
+    *block = malloc(lineSize(size) + DCACHE_LINESIZE - 1);
+    if (*block == NULL) return NULL;
+    return (u8*)(((u32)*block + DCACHE_LINESIZE - 1) & ~(DCACHE_LINESIZE - 1));
+}
+
+static void startDma(void *dramAddr, u32 devAddr, int length)
+{
+    dmaRequest.hdr.pri = OS_MESG_PRI_NORMAL;
+    dmaRequest.hdr.retQueue = &dmaQueue;
+    dmaRequest.dramAddr = dramAddr;
+    dmaRequest.devAddr = devAddr;
+    dmaRequest.size = length;
+    osEPiStartDma(nuPiCartHandle, &dmaRequest, OS_READ);
+}
+
+static void startChunk(segment *source)
+{
+    int length;
+    u8 *destination;
+
+    transferring = source;
+
+    if (source->state == ReadingHeader)
+    {
+        osInvalDCache(headerBuffer, sizeof(headerBuffer));
+        startDma(headerBuffer, (u32)source->romStart, sizeof(segmentHeader));
+        return;
+    }
+
+    // The PI only moves an even number of bytes, which the buffers' whole lines leave room for.
+    length = (source->romSize - source->requested + 1) & ~1;
+    if (length > LOADER_CHUNK_SIZE) length = LOADER_CHUNK_SIZE;
+
+    destination = source->packed != NULL ? source->packed : source->data;
+    startDma(destination + source->requested,
+        (u32)source->romStart + sizeof(segmentHeader) + source->requested, length);
+    source->requested += length;
+}
+
+// Sizes the segment's buffers from the header that just arrived. Packed data is read into a buffer of its own
+// and decompressed into place once it has all arrived.
+static void readHeader(segment *source)
+{
+    const segmentHeader *header = (const segmentHeader*)headerBuffer;
+
+    source->size = header->size;
+    source->romSize = header->packedSize > 0 ? header->packedSize : header->size;
+    source->state = ReadingData;
+    source->data = allocLines(header->size, &source->dataBlock);
+
+    if (source->data != NULL && header->packedSize > 0)
+    {
+        source->packed = allocLines(source->romSize, &source->packedBlock);
+        if (source->packed == NULL)
+        {
+            free(source->dataBlock);
+            source->data = NULL;
+        }
+    }
+
+    if (source->data == NULL)
+    {
+        source->state = Failed;
+        return;
+    }
+
+    // Stale lines over the destination could be written back on top of the DMA.
+    osInvalDCache(source->packed != NULL ? source->packed : source->data, lineSize(source->romSize));
+}
+
+static void unpackSegment(segment *source)
+{
+    if (source->packed != NULL)
+    {
+        if (unpackBlock(source->packed, source->romSize, source->data, source->size) != source->size)
+        {
+            free(source->dataBlock);
+            source->data = NULL;
+        }
+        else
+        {
+            // The RDP reads textures straight from RDRAM so nothing can be left in the data cache.
+            osWritebackDCache(source->data, source->size);
+        }
+
+        free(source->packedBlock);
+        source->packed = NULL;
+    }
+
+    source->state = source->data != NULL ? Ready : Failed;
+}
+
+static int hasArrived(segment *source)
+{
+    return source->state == Ready || source->state == Failed;
+}
+
+static void step(int block)
+{
+    OSMesg message;
+
+    if (transferring == NULL && reading != NULL) startChunk(reading);
+
+    if (transferring != NULL)
+    {
+        if (osRecvMesg(&dmaQueue, &message, block ? OS_MESG_BLOCK : OS_MESG_NOBLOCK) == -1) return;
+
+        // Keep the PI busy with the next chunk before spending any time on what just arrived.
+        segment *finished = transferring;
+        transferring = NULL;
+
+        if (finished->state == ReadingHeader) readHeader(finished);
+
+        if (finished->state == ReadingData && finished->requested < finished->romSize)
+        {
+            startChunk(finished);
+        }
+        else
+        {
+            reading = finished->next;
+            if (reading != NULL) startChunk(reading);
+            if (finished->state == ReadingData) unpackSegment(finished);
+        }
+    }
+
+    while (jobHead != NULL && hasArrived(jobHead->source))
+    {
+        loadJob *job = jobHead;
+        jobHead = job->next;
+        if (jobHead == NULL) jobTail = NULL;
+
+        // Segments that couldn't be allocated or were corrupt are dropped, leaving their actors unloaded.
+        if (job->source->state == Ready) job->loaded(job->source->data, job->source->size, job->first, job->target);
+        free(job);
+    }
+}
+
+int queueSegment(void *romStart, segmentLoaded loaded, void *target)
+{
+    segment *source;
+    loadJob *job = NULL;
+    int first = 0;
+
+    if (!queueCreated)
+    {
+        osCreateMesgQueue(&dmaQueue, dmaMessages, 1);
+        queueCreated = 1;
+    }
+
+    // Allocated before any segment is linked so a failure leaves nothing waiting on a job that never runs.
+    if (loaded != NULL)
+    {
+        job = (loadJob*)malloc(sizeof(loadJob));
+        if (job == NULL) return 0;
+    }
+
+    for (source = segments; source != NULL; source = source->next)
+    {
+        if (source->romStart == romStart) break;
+    }
+
+    if (source == NULL)
+    {
+        source = (segment*)malloc(sizeof(segment));
+        if (source == NULL)
+        {
+            free(job);
+            return 0;
+        }
+
+        source->romStart = romStart;
+        source->state = ReadingHeader;
+        source->data = NULL;
+        source->packed = NULL;
+        source->dataBlock = NULL;
+        source->packedBlock = NULL;
+        source->size = 0;
+        source->romSize = 0;
+        source->requested = 0;
+        source->next = NULL;
+
+        if (lastSegment != NULL) lastSegment->next = source;
+        else segments = source;
+        lastSegment = source;
+
+        if (reading == NULL) reading = source;
+        first = 1;
+    }
+
+    if (job != NULL)
+    {
+        job->source = source;
+        job->loaded = loaded;
+        job->target = target;
+        job->first = first;
+        job->next = NULL;
+
+        if (jobTail != NULL) jobTail->next = job;
+        else jobHead = job;
+        jobTail = job;
+    }
+
+    return 1;
+}
+
+void pumpLoads()
+{
+    const OSTime end = osGetTime() + OS_USEC_TO_CYCLES(LOADER_FRAME_BUDGET);
+
+    while (loadsPending() && osGetTime() < end) step(1);
+}
+
+void finishLoads()
+{
+    while (loadsPending()) step(1);
+}
+
+int loadsPending()
+{
+    return jobHead != NULL || reading != NULL || transferring != NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+#include <nusys.h>
+
+// Bytes moved by each PI DMA, the same blocks nuPiReadRom splits reads into.
+#ifndef LOADER_CHUNK_SIZE
+#define LOADER_CHUNK_SIZE 0x4000
+#endif
+
+// Microseconds pumpLoads may spend on loading each frame. A DMA already in flight is always waited out.
+#ifndef LOADER_FRAME_BUDGET
+#define LOADER_FRAME_BUDGET 8000
+#endif
+
+// Runs once the segment's data is in RAM. First is only set for the request that read it from ROM.
+typedef void (*segmentLoaded)(void *data, int size, int first, void *target);
+
+// Segments are read from ROM once and in the order they were queued, with later requests for the same one
+// sharing the copy. Each starts with a header giving its size, which the loader reads before allocating
+// anywhere for it. Loaded callbacks run in order too, decompressing first if need be, while the DMA for the
+// next segment is in flight. Returns 0 if there wasn't the memory to queue it.
+int queueSegment(void *romStart, segmentLoaded loaded, void *target);
+
+void pumpLoads();
+
+// Blocks until every queued segment has arrived and been handed to its callback.
+void finishLoads();
+
+int loadsPending();
+
+#endif
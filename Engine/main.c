@@ -1,9 +1,12 @@
 #include <nusys.h>
 #include <math.h>
 #include "utilities.h"
-#include "hashtable.h"
 #include "actor.h"
 #include "collision.h"
+#include "pool.h"
+#include "profiler.h"
+#include "loader.h"
+#include "render.h"
 #include "scene.h"
 #include "vector.h"
 
@@ -18,12 +21,38 @@
 
 #define SCREEN_WD 320
 #define SCREEN_HT 240
+
+// Generated in definitions.h from the number of models in the scene.
+#ifndef GFX_GLIST_LEN
 #define GFX_GLIST_LEN 2048
+#endif
+
+// Commands kept free at the end of each display list for the profiler overlay and the closing sync.
+#define GFX_GLIST_TAIL 48
+
+// Scripts update and collide this many times a second however fast frames are drawn.
+#ifndef SIMULATION_RATE
+#define SIMULATION_RATE 60
+#endif
+
+// Most steps run before a frame is drawn. Time past that is dropped so a long stall slows the game
+// down for a moment instead of leaving it forever catching up.
+#ifndef MAX_SIMULATION_STEPS
+#define MAX_SIMULATION_STEPS 4
+#endif
 
 char mem_heep[1024 * 512];
 Gfx *glistp;
-Gfx gfx_glist[GFX_GLIST_LEN];
-transform world;
+Gfx gfx_glist[GFX_BUFFER_COUNT][GFX_GLIST_LEN];
+Mtx projection[GFX_BUFFER_COUNT];
+float view[4][4];
+renderView render_view;
+volatile u32 frames_started = 0;
+volatile u32 frames_finished = 0;
+u32 gfx_glist_high_water = 0;
+u32 gfx_glist_overflows = 0;
+OSTime last_step_time = 0;
+OSTime step_time_pending = 0;
 NUContData contdata[4];
 
 static Vp view_port =
@@ -78,38 +107,54 @@ void clear_frame_buffer()
     gDPPipeSync(glistp++);
 }
 
-void setup_world_matrix(Gfx **display_list)
+void setup_world_matrix(Gfx **display_list, int buffer)
 {
     u16 persp_normal;
+    float perspective[4][4];
 
-    guPerspective(&world.projection,
+    guPerspectiveF(perspective,
         &persp_normal,
         80.0F, SCREEN_WD / SCREEN_HT,
         0.1F, 1000.0F, 1.0F);
 
+    // Folding the camera into the projection lets each model load its matrix without a push or pop.
+    setRenderView(&render_view, view, perspective, SCREEN_HT);
+    guMtxF2L(render_view.viewProjection, &projection[buffer]);
+
     gSPPerspNormalize((*display_list)++, persp_normal);
 
-    gSPMatrix((*display_list)++, OS_K0_TO_PHYSICAL(&world.projection),
+    gSPMatrix((*display_list)++, OS_K0_TO_PHYSICAL(&projection[buffer]),
         G_MTX_PROJECTION | G_MTX_LOAD | G_MTX_NOPUSH);
+}
 
-    gSPMatrix((*display_list)++, OS_K0_TO_PHYSICAL(&world.rotation),
-        G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH);
+void check_display_list(int buffer, int skipped)
+{
+    const u32 used = glistp - gfx_glist[buffer];
+    if (used > gfx_glist_high_water) gfx_glist_high_water = used;
 
-    gSPMatrix((*display_list)++, OS_K0_TO_PHYSICAL(&world.translation),
-        G_MTX_MODELVIEW | G_MTX_MUL | G_MTX_NOPUSH);
+    // Actors that didn't fit are only missing for the frame, so report the first time and keep count after.
+    if (skipped > 0 && gfx_glist_overflows++ == 0)
+    {
+        osSyncPrintf("Display list full at %d commands, %d actors not drawn\n", GFX_GLIST_LEN, skipped);
+    }
 }
 
-void create_display_list()
+void create_display_list(int buffer)
 {
-    glistp = gfx_glist;
+    int skipped;
+
+    glistp = gfx_glist[buffer];
     rcp_init();
     clear_frame_buffer();
-    setup_world_matrix(&glistp);
-    _UER_Draw(&glistp);
+    setup_world_matrix(&glistp, buffer);
+    skipped = _UER_Draw(&glistp, gfx_glist[buffer] + GFX_GLIST_LEN - GFX_GLIST_TAIL, &render_view, buffer);
+    PROFILE_DRAW(&glistp, SCREEN_WD, SCREEN_HT);
     gDPFullSync(glistp++);
     gSPEndDisplayList(glistp++);
-    nuGfxTaskStart(gfx_glist, (s32)(glistp - gfx_glist) * sizeof(Gfx),
+    check_display_list(buffer, skipped);
+    nuGfxTaskStart(gfx_glist[buffer], (s32)(glistp - gfx_glist[buffer]) * sizeof(Gfx),
         NU_GFX_UCODE_F3DEX, NU_SC_SWAPBUFFER);
+    PROFILE_TASK_QUEUED();
 }
 
 void check_inputs()
@@ -118,26 +163,94 @@ void check_inputs()
     _UER_Input(contdata);
 }
 
-void update_camera()
+void update_camera(float blend)
 {
     actor *camera = _UER_ActiveCamera;
     if (camera != NULL)
     {
-        guTranslate(&world.translation, -camera->position.x, -camera->position.y, camera->position.z);
-        guRotate(&world.rotation, camera->rotationAngle, camera->rotationAxis.x, camera->rotationAxis.y,
-            -camera->rotationAxis.z);
+        const actorPose pose = blendActorPose(camera, blend);
+        float translation[4][4], rotation[4][4];
+        guTranslateF(translation, -SCALAR_TO_FLOAT(pose.position.x), -SCALAR_TO_FLOAT(pose.position.y),
+            SCALAR_TO_FLOAT(pose.position.z));
+        guRotateF(rotation, SCALAR_TO_FLOAT(pose.rotationAngle), SCALAR_TO_FLOAT(pose.rotationAxis.x),
+            SCALAR_TO_FLOAT(pose.rotationAxis.y), -SCALAR_TO_FLOAT(pose.rotationAxis.z));
+        guMtxCatF(translation, rotation, view);
     }
 }
 
+void gfx_task_end(NUScTask *task)
+{
+    PROFILE_TASK_ENDED();
+    frames_finished++;
+}
+
+void simulate_step()
+{
+    saveActorPoses(_UER_Actors);
+
+    PROFILE_BEGIN(ProfileInput);
+    check_inputs();
+    PROFILE_END(ProfileInput);
+
+    PROFILE_BEGIN(ProfileUpdate);
+    _UER_Update();
+    PROFILE_END(ProfileUpdate);
+
+    PROFILE_BEGIN(ProfileCollide);
+    _UER_Collide();
+    PROFILE_END(ProfileCollide);
+
+    // Destroyed actors are only released once nothing else this step can still be using them.
+    PROFILE_BEGIN(ProfileRelease);
+    if (!isActorAlive(_UER_ActiveCamera)) _UER_ActiveCamera = NULL;
+    releaseDestroyedActors(_UER_Actors);
+    PROFILE_END(ProfileRelease);
+}
+
 void gfx_callback(int pendingGfx)
 {
-    if (pendingGfx < 1)
+    // A buffer is free once the task that last read it has finished, which lets the CPU
+    // build and update the next frame while the RCP is still drawing the previous one.
+    if (frames_started - frames_finished < GFX_BUFFER_COUNT)
     {
-        create_display_list();
-        check_inputs();
-        update_camera();
-        _UER_Update();
-        _UER_Collide();
+        const OSTime now = osGetTime();
+        const OSTime step = OS_USEC_TO_CYCLES(1000000 / SIMULATION_RATE);
+        int steps = 0;
+
+        PROFILE_FRAME_START();
+
+        // Segments still streaming in from ROM get part of every frame until they've all arrived.
+        PROFILE_BEGIN(ProfileLoads);
+        pumpLoads();
+        PROFILE_END(ProfileLoads);
+
+        // Frames the RCP is too busy to start don't slow the game down, they just run more steps before the next.
+        step_time_pending += now - last_step_time;
+        last_step_time = now;
+
+        while (step_time_pending >= step && steps < MAX_SIMULATION_STEPS)
+        {
+            simulate_step();
+            step_time_pending -= step;
+            steps++;
+        }
+
+        if (step_time_pending >= step) step_time_pending %= step;
+
+        // Actors are drawn part of the way from where the last step started to where it left them,
+        // so motion stays smooth when frames and steps don't line up.
+        render_view.blend = (float)step_time_pending / (float)step;
+
+        PROFILE_BEGIN(ProfileCamera);
+        update_camera(render_view.blend);
+        PROFILE_END(ProfileCamera);
+
+        PROFILE_BEGIN(ProfileDisplayList);
+        create_display_list(frames_started % GFX_BUFFER_COUNT);
+        frames_started++;
+        PROFILE_END(ProfileDisplayList);
+
+        PROFILE_FRAME_END();
     }
 }
 
@@ -150,9 +263,10 @@ void set_default_camera()
 {
     for (int i = 0; i < vector_size(_UER_Actors); i++)
     {
-        if (vector_get(_UER_Actors, i)->type == Camera)
+        actor *candidate = vector_get(_UER_Actors, i);
+        if (candidate != NULL && candidate->type == Camera)
         {
-            _UER_ActiveCamera = vector_get(_UER_Actors, i);
+            _UER_ActiveCamera = candidate;
             break;
         }
     }
@@ -172,10 +286,13 @@ void mainproc()
     {
         _UER_Load();
         set_default_camera();
-        _UER_Mappings();
+        update_camera(1.0F);
+        _UER_Collisions();
         _UER_Start();
     }
 
+    last_step_time = osGetTime();
+    nuGfxTaskEndFuncSet(gfx_task_end);
     nuGfxFuncSet((NUGfxFunc)gfx_callback);
     nuGfxDisplayOn();
 
@@ -0,0 +1,160 @@
+#include <malloc.h>
+#include "pool.h"
+
+enum slotState { SlotFree, SlotLive, SlotDestroyed };
+
+actor *actorSlots = NULL;
+transformState *actorStates = NULL;
+sphereBounds *actorBounds = NULL;
+transform *actorTransforms = NULL;
+actorModel *actorModels = NULL;
+
+static u16 generations[ACTOR_POOL_CAPACITY];
+static s16 nextFree[ACTOR_POOL_CAPACITY];
+static u8 states[ACTOR_POOL_CAPACITY];
+static u8 recyclable[ACTOR_POOL_CAPACITY];
+static s16 destroyed[ACTOR_POOL_CAPACITY];
+static int destroyedCount = 0;
+static int freeHead = -1;
+static int used = 0;
+
+static int slotIndex(actor *target)
+{
+    if (actorSlots == NULL || target < actorSlots || target >= actorSlots + used) return -1;
+    return ACTOR_SLOT(target);
+}
+
+static int reserveSlots()
+{
+    if (actorSlots != NULL) return 1;
+
+    actorStates = (transformState*)malloc(sizeof(transformState) * ACTOR_POOL_CAPACITY);
+    actorBounds = (sphereBounds*)malloc(sizeof(sphereBounds) * ACTOR_POOL_CAPACITY);
+    actorTransforms = (transform*)malloc(sizeof(transform) * ACTOR_POOL_CAPACITY);
+    actorModels = (actorModel*)malloc(sizeof(actorModel) * ACTOR_POOL_CAPACITY);
+
+    if (actorStates == NULL || actorBounds == NULL || actorTransforms == NULL || actorModels == NULL) return 0;
+
+    actorSlots = (actor*)malloc(sizeof(actor) * ACTOR_POOL_CAPACITY);
+    return actorSlots != NULL;
+}
+
+actor *allocActor(int recycle)
+{
+    int index;
+
+    if (!reserveSlots()) return NULL;
+
+    if (recycle && freeHead >= 0)
+    {
+        index = freeHead;
+        freeHead = nextFree[index];
+    }
+    else if (used < ACTOR_POOL_CAPACITY)
+    {
+        index = used++;
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (generations[index] == 0) generations[index] = 1;
+    states[index] = SlotLive;
+    recyclable[index] = recycle;
+    actorStates[index].dirty = 1;
+    actorStates[index].posed = 0;
+    return &actorSlots[index];
+}
+
+actor *spawnActor(vector actors, actor *source)
+{
+    const int from = slotIndex(source);
+    if (from < 0) return NULL;
+
+    actor *spawned = allocActor(1);
+    if (spawned == NULL) return NULL;
+
+    const int index = ACTOR_SLOT(spawned);
+
+    // The slot's arrays hold whatever its last occupant left, so the copy gets the source's matrices too
+    // rather than waiting for the next draw to compose its own.
+    *spawned = *source;
+    actorBounds[index] = actorBounds[from];
+    actorTransforms[index] = actorTransforms[from];
+    actorModels[index] = actorModels[from];
+
+    // Every slot handed out is in the vector, so a new slot is always the next index.
+    if (index < vector_size(actors))
+        vector_put(actors, index, spawned);
+    else
+        vector_add(actors, spawned);
+
+    return spawned;
+}
+
+void destroyActor(actor *target)
+{
+    const int index = slotIndex(target);
+    if (index < 0 || states[index] != SlotLive) return;
+
+    states[index] = SlotDestroyed;
+    destroyed[destroyedCount++] = index;
+}
+
+void releaseDestroyedActors(vector actors)
+{
+    for (int i = 0; i < destroyedCount; i++)
+    {
+        const int index = destroyed[i];
+
+        vector_put(actors, index, NULL);
+        states[index] = SlotFree;
+        if (++generations[index] == 0) generations[index] = 1;
+
+        if (recyclable[index])
+        {
+            nextFree[index] = freeHead;
+            freeHead = index;
+        }
+    }
+
+    destroyedCount = 0;
+}
+
+void saveActorPoses(vector actors)
+{
+    for (int i = 0; i < vector_size(actors); i++)
+    {
+        actor *current = vector_get(actors, i);
+        transformState *state;
+        if (current == NULL) continue;
+
+        state = &actorStates[i];
+        state->previous.position = current->position;
+        state->previous.rotationAxis = current->rotationAxis;
+        state->previous.scale = current->scale;
+        state->previous.rotationAngle = current->rotationAngle;
+        state->posed = 1;
+    }
+}
+
+int isActorAlive(actor *target)
+{
+    const int index = slotIndex(target);
+    return index >= 0 && states[index] == SlotLive;
+}
+
+actorHandle getActorHandle(actor *target)
+{
+    const int index = slotIndex(target);
+    if (index < 0 || states[index] != SlotLive) return NULL_HANDLE;
+    return ((u32)generations[index] << 16) | index;
+}
+
+actor *resolveActorHandle(actorHandle handle)
+{
+    const int index = handle & 0xFFFF;
+    if (handle == NULL_HANDLE || index >= used || states[index] != SlotLive) return NULL;
+    return generations[index] == handle >> 16 ? &actorSlots[index] : NULL;
+}
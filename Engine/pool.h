@@ -0,0 +1,52 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <nusys.h>
+#include "actor.h"
+#include "vector.h"
+
+// Most actors alive at once, scene and instantiated together. The pool takes this many actors from the
+// heap once so spawning and destroying never fragments it. The editor refuses to build scenes with more
+// actors than this, so keep ActorPoolCapacity in Build.h in step.
+#ifndef ACTOR_POOL_CAPACITY
+#define ACTOR_POOL_CAPACITY 256
+#endif
+
+// Pool slot in the low 16 bits and the slot's generation in the high 16, so a handle to a destroyed
+// actor stops resolving even after its slot is reused.
+typedef u32 actorHandle;
+
+#define NULL_HANDLE 0
+
+// Engine data for each slot sits in parallel arrays beside the actors, split by the loops that read it,
+// so updating and culling never pull matrices or display lists into the cache.
+extern actor *actorSlots;
+extern transformState *actorStates;
+extern sphereBounds *actorBounds;
+extern transform *actorTransforms;
+extern actorModel *actorModels;
+
+// Index of a pool actor into each of the arrays above, which is also its index in the actor vector.
+#define ACTOR_SLOT(target) ((target) - actorSlots)
+
+// Scene actors pass zero so their slots, which generated code refers to by index, are never reused.
+actor *allocActor(int recycle);
+
+// Allocates a reusable slot holding a copy of the source actor and puts it at the same index in the actor vector.
+actor *spawnActor(vector actors, actor *source);
+
+// Destroyed actors stay readable until releaseDestroyedActors runs at the end of the frame.
+void destroyActor(actor *target);
+
+void releaseDestroyedActors(vector actors);
+
+// Runs before each simulation step so drawing can blend every actor from where the step started.
+void saveActorPoses(vector actors);
+
+int isActorAlive(actor *target);
+
+actorHandle getActorHandle(actor *target);
+
+actor *resolveActorHandle(actorHandle handle);
+
+#endif
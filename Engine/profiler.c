@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include "profiler.h"
+
+#ifdef UER_PROFILE
+
+// The CPU counter runs at half the CPU clock and the RDP's counters at the 62.5 MHz RCP clock.
+#define COUNT_TO_USEC(count) ((u32)OS_CYCLES_TO_USEC(count))
+#define RDP_CLOCKS_TO_USEC(clocks) ((clocks) * 2 / 125)
+
+// More than enough for the display list buffers that can be waiting on the RCP at once.
+#define MAX_QUEUED_TASKS 4
+
+#define BAR_HEIGHT 4
+#define BAR_MARGIN 16
+
+profileFrame profileFrames[PROFILE_FRAMES];
+int profileOverlay = 1;
+char profileReport[PROFILE_REPORT_SIZE];
+
+static const char *zoneNames[ProfileZoneCount] = { "loads", "dlist", "input", "camera", "update", "collide",
+    "release" };
+static const u16 zoneColors[ProfileZoneCount] = {
+    GPACK_RGBA5551(128, 128, 128, 1), GPACK_RGBA5551(255, 64, 64, 1), GPACK_RGBA5551(255, 160, 0, 1),
+    GPACK_RGBA5551(255, 255, 0, 1), GPACK_RGBA5551(64, 255, 64, 1), GPACK_RGBA5551(0, 192, 255, 1),
+    GPACK_RGBA5551(192, 64, 255, 1)
+};
+
+static int recording = 0;
+static u32 frameStart;
+static u32 zoneStarts[ProfileZoneCount];
+static u32 zoneCounts[ProfileZoneCount];
+
+// Frames queue up behind the tasks that draw them. Tasks end on the scheduler's thread, which only moves the
+// head while the graphics thread only moves the tail.
+static int queuedSlots[MAX_QUEUED_TASKS];
+static u32 queuedCounts[MAX_QUEUED_TASKS];
+static volatile int queuedHead = 0;
+static volatile int queuedTail = 0;
+static u32 lastTaskEnd = 0;
+static volatile int lastCompleted = -1;
+static volatile int reportReady = 0;
+
+static void writeReport()
+{
+    u32 totals[ProfileZoneCount] = { 0 };
+    u32 cpu = 0, rcp = 0, rdp = 0;
+    int length;
+
+    for (int i = 0; i < PROFILE_FRAMES; i++)
+    {
+        for (int zone = 0; zone < ProfileZoneCount; zone++) totals[zone] += profileFrames[i].zones[zone];
+        cpu += profileFrames[i].cpu;
+        rcp += profileFrames[i].rcp;
+        rdp += profileFrames[i].rdp;
+    }
+
+    length = sprintf(profileReport, "UERPROF average us over %d frames\n", PROFILE_FRAMES);
+
+    for (int zone = 0; zone < ProfileZoneCount; zone++)
+    {
+        length += sprintf(profileReport + length, "%-8s %6lu\n", zoneNames[zone],
+            (unsigned long)(totals[zone] / PROFILE_FRAMES));
+    }
+
+    sprintf(profileReport + length, "cpu      %6lu\nrcp      %6lu\nrdp      %6lu\n",
+        (unsigned long)(cpu / PROFILE_FRAMES), (unsigned long)(rcp / PROFILE_FRAMES),
+        (unsigned long)(rdp / PROFILE_FRAMES));
+    osSyncPrintf("%s", profileReport);
+}
+
+void profileFrameStart()
+{
+    // The report is written here rather than when the last frame's task ends to keep it off the scheduler.
+    if (reportReady)
+    {
+        reportReady = 0;
+        writeReport();
+    }
+
+    recording = (recording + 1) % PROFILE_FRAMES;
+
+    for (int zone = 0; zone < ProfileZoneCount; zone++) zoneCounts[zone] = 0;
+    frameStart = osGetCount();
+}
+
+void profileBegin(enum profileZone zone)
+{
+    zoneStarts[zone] = osGetCount();
+}
+
+void profileEnd(enum profileZone zone)
+{
+    zoneCounts[zone] += osGetCount() - zoneStarts[zone];
+}
+
+void profileFrameEnd()
+{
+    profileFrame *frame = &profileFrames[recording];
+
+    frame->cpu = COUNT_TO_USEC(osGetCount() - frameStart);
+    for (int zone = 0; zone < ProfileZoneCount; zone++) frame->zones[zone] = COUNT_TO_USEC(zoneCounts[zone]);
+}
+
+void profileTaskQueued()
+{
+    const int tail = queuedTail;
+
+    queuedSlots[tail] = recording;
+    queuedCounts[tail] = osGetCount();
+    queuedTail = (tail + 1) % MAX_QUEUED_TASKS;
+}
+
+void profileTaskEnded()
+{
+    const u32 now = osGetCount();
+    const int head = queuedHead;
+    profileFrame *frame;
+    u32 start;
+
+    if (head == queuedTail) return;
+
+    // A task queued behind another only starts once that one is done.
+    frame = &profileFrames[queuedSlots[head]];
+    start = queuedCounts[head];
+    if ((s32)(lastTaskEnd - start) > 0) start = lastTaskEnd;
+
+    frame->rcp = COUNT_TO_USEC(now - start);
+    frame->rdp = RDP_CLOCKS_TO_USEC(IO_READ(DPC_PIPEBUSY_REG));
+    IO_WRITE(DPC_STATUS_REG, DPC_CLR_CLOCK_CTR | DPC_CLR_CMD_CTR | DPC_CLR_PIPE_CTR | DPC_CLR_TMEM_CTR);
+
+    lastTaskEnd = now;
+    lastCompleted = queuedSlots[head];
+    if (lastCompleted == PROFILE_FRAMES - 1) reportReady = 1;
+    queuedHead = (head + 1) % MAX_QUEUED_TASKS;
+}
+
+static void drawBar(Gfx **displayList, int x, int width, int y, u16 color)
+{
+    if (width <= 0) return;
+
+    gDPPipeSync((*displayList)++);
+    gDPSetFillColor((*displayList)++, (u32)color << 16 | color);
+    gDPFillRectangle((*displayList)++, x, y, x + width - 1, y + BAR_HEIGHT - 1);
+}
+
+static int barWidth(u32 usec, int scale)
+{
+    // A frame over budget fills its row rather than running off the screen.
+    if (usec >= PROFILE_FRAME_BUDGET) return scale;
+    return (int)(usec * scale / PROFILE_FRAME_BUDGET);
+}
+
+void profileDraw(Gfx **displayList, int screenWidth, int screenHeight)
+{
+    const int scale = screenWidth - BAR_MARGIN * 2;
+    const int top = screenHeight - BAR_MARGIN - BAR_HEIGHT * 5;
+    const int slot = lastCompleted;
+    const u16 white = GPACK_RGBA5551(255, 255, 255, 1);
+    const profileFrame *frame;
+    int x = BAR_MARGIN;
+
+    if (!profileOverlay || slot < 0) return;
+
+    // The newest frame the RCP has finished, so all three rows come from the same one.
+    frame = &profileFrames[slot];
+
+    gDPPipeSync((*displayList)++);
+    gDPSetCycleType((*displayList)++, G_CYC_FILL);
+    gDPSetRenderMode((*displayList)++, G_RM_NOOP, G_RM_NOOP2);
+
+    for (int zone = 0; zone < ProfileZoneCount; zone++)
+    {
+        // Zones share one row, so each only gets what the ones before it left of the budget.
+        int width = barWidth(frame->zones[zone], scale);
+        if (width > BAR_MARGIN + scale - x) width = BAR_MARGIN + scale - x;
+        drawBar(displayList, x, width, top, zoneColors[zone]);
+        x += width;
+    }
+
+    drawBar(displayList, BAR_MARGIN, barWidth(frame->rcp, scale), top + BAR_HEIGHT * 2, white);
+    drawBar(displayList, BAR_MARGIN, barWidth(frame->rdp, scale), top + BAR_HEIGHT * 4, GPACK_RGBA5551(255, 0, 255, 1));
+
+    // Tick at the end of the frame's budget on each row.
+    for (int row = 0; row < 3; row++) drawBar(displayList, BAR_MARGIN + scale, 2, top + BAR_HEIGHT * 2 * row, white);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <nusys.h>
+
+// Stages of a frame on the CPU. Input, update, collide and release add up over every simulation step the frame ran.
+enum profileZone
+{
+    ProfileLoads,
+    ProfileDisplayList,
+    ProfileInput,
+    ProfileCamera,
+    ProfileUpdate,
+    ProfileCollide,
+    ProfileRelease,
+    ProfileZoneCount
+};
+
+// Frames kept in the ring buffer. The report averages over all of them each time it wraps.
+#ifndef PROFILE_FRAMES
+#define PROFILE_FRAMES 64
+#endif
+
+// Microseconds the overlay draws as a full frame, marked by the white tick.
+#ifndef PROFILE_FRAME_BUDGET
+#define PROFILE_FRAME_BUDGET 16667
+#endif
+
+#define PROFILE_REPORT_SIZE 512
+
+// Timings are in microseconds. The RCP time spans from the task starting, which is when it's queued or when
+// the task ahead of it ends, to the RDP finishing. The RDP time is only the cycles its pipeline was busy.
+typedef struct profileFrame
+{
+    u32 zones[ProfileZoneCount];
+    u32 cpu;
+    u32 rcp;
+    u32 rdp;
+} profileFrame;
+
+// Build with -DUER_PROFILE to time each stage of the frame. Otherwise the macros below compile to nothing.
+#ifdef UER_PROFILE
+
+extern profileFrame profileFrames[PROFILE_FRAMES];
+
+// Scripts can clear this to hide the bar graph drawn over the bottom of the screen.
+extern int profileOverlay;
+
+// Averages over the ring buffer as text, refreshed each time it wraps. ROM builds stub out osSyncPrintf so
+// it's kept behind the UERPROF marker where a debugger or a dump of RDRAM from the host can find it.
+extern char profileReport[PROFILE_REPORT_SIZE];
+
+void profileFrameStart();
+
+void profileBegin(enum profileZone zone);
+
+void profileEnd(enum profileZone zone);
+
+void profileFrameEnd();
+
+void profileTaskQueued();
+
+void profileTaskEnded();
+
+void profileDraw(Gfx **displayList, int screenWidth, int screenHeight);
+
+#define PROFILE_FRAME_START() profileFrameStart()
+#define PROFILE_BEGIN(zone) profileBegin(zone)
+#define PROFILE_END(zone) profileEnd(zone)
+#define PROFILE_FRAME_END() profileFrameEnd()
+#define PROFILE_TASK_QUEUED() profileTaskQueued()
+#define PROFILE_TASK_ENDED() profileTaskEnded()
+#define PROFILE_DRAW(displayList, width, height) profileDraw(displayList, width, height)
+
+#else
+
+#define PROFILE_FRAME_START()
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+#define PROFILE_FRAME_END()
+#define PROFILE_TASK_QUEUED()
+#define PROFILE_TASK_ENDED()
+#define PROFILE_DRAW(displayList, width, height)
+
+#endif
+
+#endif
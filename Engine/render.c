@@ -0,0 +1,192 @@
+#include <nusys.h>
+#include "utilities.h"
+#include "render.h"
+#include "pool.h"
+
+typedef struct drawEntry
+{
+    actorModel *model;
+    int slot;
+    float depth;
+} drawEntry;
+
+// Pool actors sit at their slot in the vector so there can never be more entries than slots. Keeping both
+// halves of the sort here means drawing never has to allocate and can't fail part way through a frame.
+static drawEntry entryBuffers[2][ACTOR_POOL_CAPACITY];
+static drawEntry *entries = entryBuffers[0];
+static drawEntry *scratch = entryBuffers[1];
+
+// Texture the last display list left in TMEM. The RDP runs each frame's list after the one before and only
+// drawActors loads textures, so whatever one frame ends with is still resident when the next begins.
+static void *residentTexture = NULL;
+
+// Groups draws sharing render state and then texture, nearest first within each group.
+static int drawsBefore(drawEntry *a, drawEntry *b)
+{
+    if (a->model->mesh.stateKey != b->model->mesh.stateKey)
+        return a->model->mesh.stateKey < b->model->mesh.stateKey;
+
+    if (a->model->texture != b->model->texture)
+        return (u32)a->model->texture < (u32)b->model->texture;
+
+    return a->depth <= b->depth;
+}
+
+// Bottom-up merge sort, which keeps equal draws in a stable order from frame to frame.
+static void sortEntries(int count)
+{
+    for (int width = 1; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += width * 2)
+        {
+            int middle = start + width < count ? start + width : count;
+            int end = start + width * 2 < count ? start + width * 2 : count;
+            int left = start, right = middle, out = start;
+
+            while (left < middle && right < end)
+                scratch[out++] = drawsBefore(&entries[left], &entries[right]) ? entries[left++] : entries[right++];
+
+            while (left < middle) scratch[out++] = entries[left++];
+            while (right < end) scratch[out++] = entries[right++];
+        }
+
+        drawEntry *sorted = scratch;
+        scratch = entries;
+        entries = sorted;
+    }
+}
+
+void setRenderView(renderView *target, float view[4][4], float projection[4][4], int screenHeight)
+{
+    float (*m)[4] = target->viewProjection;
+
+    guMtxCatF(view, projection, target->viewProjection);
+
+    // Clip space planes pulled from the combined matrix and normalized so distances are in world units.
+    for (int i = 0; i < 6; i++)
+    {
+        int axis = i / 2;
+        float sign = i % 2 == 0 ? 1 : -1;
+        float length;
+
+        for (int j = 0; j < 4; j++)
+        {
+            target->planes[i][j] = m[j][3] + sign * m[j][axis];
+        }
+
+        length = sqrtf(target->planes[i][0] * target->planes[i][0] + target->planes[i][1] * target->planes[i][1]
+            + target->planes[i][2] * target->planes[i][2]);
+
+        for (int j = 0; j < 4; j++)
+        {
+            target->planes[i][j] /= length;
+        }
+    }
+
+    // Pixels covered by one world unit at a distance of one.
+    target->pixelScale = projection[1][1] * screenHeight / 2;
+}
+
+// Rejects actors entirely outside the view or too small to cover a pixel.
+static int isCulled(sphereBounds *bounds, renderView *view, float depth)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        float *plane = view->planes[i];
+        float distance = bounds->center.x * plane[0] + bounds->center.y * plane[1]
+            + bounds->center.z * plane[2] + plane[3];
+
+        if (distance < -bounds->radius) return 1;
+    }
+
+    return depth > 0 && bounds->radius * view->pixelScale < CULL_PIXEL_RADIUS * depth;
+}
+
+// Steps through levels of detail by view distance, switching a margin past each threshold so an actor
+// hovering around one doesn't flicker between levels. Zero distances never switch.
+static void selectLod(actorModel *model, float depth)
+{
+    int lod = model->lod < model->mesh.lodCount ? model->lod : 0;
+
+    while (lod + 1 < model->mesh.lodCount && model->lodDistances[lod] > 0
+        && depth > model->lodDistances[lod] * (1 + LOD_HYSTERESIS)) lod++;
+
+    while (lod > 0 && (model->lodDistances[lod - 1] <= 0
+        || depth < model->lodDistances[lod - 1] * (1 - LOD_HYSTERESIS))) lod--;
+
+    model->lod = lod;
+}
+
+int drawActors(vector actors, renderView *view, Gfx **displayList, Gfx *displayListEnd, int buffer)
+{
+    int count = 0;
+    u32 currentState = 0;
+
+    for (int i = 0; i < vector_size(actors); i++)
+    {
+        actor *current = vector_get(actors, i);
+        if (current == NULL) continue;
+
+        // Collision works from each actor's own pose, so only what gets drawn needs its matrices composed.
+        if (!current->visible || current->type != Model || actorModels[i].mesh.state == NULL) continue;
+
+        updateTransform(current, buffer, view->blend);
+
+        // Pool actors sit at their slot in the vector, so i also indexes the per-slot arrays.
+        sphereBounds *bounds = &actorBounds[i];
+
+        // Clip space w is the distance along the camera's view direction.
+        float (*m)[4] = view->viewProjection;
+        float depth = bounds->center.x * m[0][3] + bounds->center.y * m[1][3] + bounds->center.z * m[2][3] + m[3][3];
+
+        if (isCulled(bounds, view, depth)) continue;
+
+        selectLod(&actorModels[i], depth);
+
+        entries[count].model = &actorModels[i];
+        entries[count].slot = i;
+        entries[count].depth = depth;
+        count++;
+    }
+
+    sortEntries(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        actorModel *current = entries[i].model;
+
+        int synced = 0;
+
+        // Whatever is left once the list is full is dropped for this frame and reported by the caller.
+        if (*displayList + GFX_ACTOR_COMMANDS > displayListEnd) return count - i;
+
+        // State lists begin with a pipe sync of their own.
+        if (current->mesh.stateKey != currentState)
+        {
+            gSPDisplayList((*displayList)++, current->mesh.state);
+            currentState = current->mesh.stateKey;
+            synced = 1;
+        }
+
+        // TMEM keeps the last texture loaded, palette included, even across untextured draws.
+        if (current->mesh.textureLoad != NULL && current->texture != residentTexture)
+        {
+            if (!synced) gDPPipeSync((*displayList)++);
+
+            gSPDisplayList((*displayList)++, current->mesh.textureLoad);
+            residentTexture = current->texture;
+        }
+
+        // The camera lives in the projection matrix so the model matrix replaces the modelview outright.
+        gSPMatrix((*displayList)++, OS_K0_TO_PHYSICAL(&actorTransforms[entries[i].slot].model[buffer]),
+            G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH);
+
+        gSPDisplayList((*displayList)++, current->mesh.geometry[current->lod]);
+
+        // Tiled textures load each tile as their geometry draws, which overwrites the texels of whatever was
+        // resident. An indexed one's palette is loaded up front and stays, so its texture still counts.
+        if (current->mesh.tiled && current->mesh.textureLoad == NULL) residentTexture = NULL;
+    }
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include <nusys.h>
+#include "actor.h"
+#include "vector.h"
+
+// Actors whose bounding sphere projects to a smaller radius than this, in pixels, are skipped.
+#ifndef CULL_PIXEL_RADIUS
+#define CULL_PIXEL_RADIUS 0.5F
+#endif
+
+// Fraction past a level of detail distance an actor has to move before it switches level.
+#ifndef LOD_HYSTERESIS
+#define LOD_HYSTERESIS 0.1F
+#endif
+
+// Most commands drawActors adds for one actor: its state list, a pipe sync and texture load, its matrix and
+// its geometry. The editor sizes each frame's display list from this and the number of models in the scene.
+#define GFX_ACTOR_COMMANDS 5
+
+typedef struct renderView
+{
+    float viewProjection[4][4];
+    float planes[6][4];
+    float pixelScale;
+
+    // How far between the last two simulation steps to draw actors, from 0 at the earlier one to 1.
+    float blend;
+} renderView;
+
+void setRenderView(renderView *target, float view[4][4], float projection[4][4], int screenHeight);
+
+// Stops short of displayListEnd rather than writing past it, returning how many visible actors were left out.
+int drawActors(vector actors, renderView *view, Gfx **displayList, Gfx *displayListEnd, int buffer);
+
+#endif
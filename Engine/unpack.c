@@ -0,0 +1,73 @@
+#include "unpack.h"
+
+// Level 2 matches with this in their offset fields carry a 16-bit distance past it in the next two bytes.
+#define FAR_DISTANCE 8191
+
+int unpackBlock(const void *input, int length, void *output, int maxOutput)
+{
+    const unsigned char *ip = (const unsigned char*)input;
+    const unsigned char *ipEnd = ip + length;
+    unsigned char *op = (unsigned char*)output;
+    unsigned char *opEnd = op + maxOutput;
+    int level;
+    unsigned int control;
+
+    if (length <= 0) return 0;
+
+    // The first byte's top bits hold the level, and its first instruction is always a literal run.
+    level = (*ip >> 5) + 1;
+    control = *ip++ & 31;
+    if (level > 2) return 0;
+
+    for (;;)
+    {
+        if (control >= 32)
+        {
+            // Back reference: the top three bits hold the length and the rest the high bits of the distance.
+            unsigned int size = (control >> 5) - 1;
+            unsigned int distance = (control & 31) << 8;
+            const unsigned char *ref;
+
+            if (size == 6)
+            {
+                unsigned int extra;
+
+                do
+                {
+                    if (ip >= ipEnd) return 0;
+                    extra = *ip++;
+                    size += extra;
+                } while (level == 2 && extra == 255);
+            }
+
+            if (ip >= ipEnd) return 0;
+            distance += *ip++;
+
+            if (level == 2 && distance == ((31 << 8) | 255))
+            {
+                if (ip + 2 > ipEnd) return 0;
+                distance = FAR_DISTANCE + ((ip[0] << 8) | ip[1]);
+                ip += 2;
+            }
+
+            size += 3;
+            ref = op - distance - 1;
+            if (ref < (unsigned char*)output || op + size > opEnd) return 0;
+
+            // Byte at a time since runs overlap the bytes they repeat.
+            while (size-- > 0) *op++ = *ref++;
+        }
+        else
+        {
+            const unsigned int size = control + 1;
+            if (ip + size > ipEnd || op + size > opEnd) return 0;
+
+            for (unsigned int i = 0; i < size; i++) *op++ = *ip++;
+        }
+
+        if (ip >= ipEnd) break;
+        control = *ip++;
+    }
+
+    return (int)(op - (unsigned char*)output);
+}
@@ -0,0 +1,8 @@
+#ifndef _UNPACK_H_
+#define _UNPACK_H_
+
+// Decompresses a FastLZ block of either level, as the editor compresses ROM segments, and returns the number
+// of bytes written to output. Returns 0 if the block is corrupt or wouldn't fit in maxOutput.
+int unpackBlock(const void *input, int length, void *output, int maxOutput);
+
+#endif
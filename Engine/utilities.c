@@ -1,7 +1,5 @@
 #include "utilities.h"
 
-#include <malloc.h>
-
 void rom_2_ram(void *from_addr, void *to_addr, s32 seq_size)
 {
     // If size is odd-numbered, cannot send over PI, so make it even.
@@ -9,80 +7,34 @@ void rom_2_ram(void *from_addr, void *to_addr, s32 seq_size)
     nuPiReadRom((u32)from_addr, to_addr, seq_size);
 }
 
-unsigned short *image_24_to_16(const unsigned char *data, int size_x, int size_y)
-{
-    unsigned short *temp = (unsigned short *)malloc(size_x * size_y * 2);
-
-    for (int y = 0; y < size_y; y++)
-    {
-        for (int x = 0; x < size_x; x++)
-        {
-            temp[x + y * size_y] = RGB5551(data[x * 3 + y * size_y * 3],
-                data[x * 3 + y * size_y * 3 + 1],
-                data[x * 3 + y * size_y * 3 + 2]);
-        }
-    }
-
-    return temp;
-}
-
-float vec3_dot(vector3 a, vector3 b)
+static fixed32 mtx_element(Mtx *mtx, int row, int column)
 {
-    return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+    // Integer halves fill the first 16 shorts and fraction halves the next 16, as guMtxF2L lays them out.
+    return ((int)((s16*)mtx->m)[row * 4 + column] << 16) | ((u16*)mtx->m)[16 + row * 4 + column];
 }
 
-float vec3_len(vector3 a, vector3 b)
+matrix3 mat3_from_mtx(Mtx *mtx)
 {
-    return sqrtf(vec3_dot(a, b));
-}
+    matrix3 result;
 
-vector3 vec3_norm(vector3 vector)
-{
-    const float len = vec3_len(vector, vector);
-    return (vector3) { vector.x / len, vector.y / len, vector.z / len };
-}
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            result.m[i][j] = FIXED_TO_SCALAR(mtx_element(mtx, i, j));
 
-vector3 vec3_add(vector3 a, vector3 b)
-{
-    a.x += b.x;
-    a.y += b.y;
-    a.z += b.z;
-    return a;
-}
-
-vector3 vec3_sub(vector3 a, vector3 b)
-{
-    a.x -= b.x;
-    a.y -= b.y;
-    a.z -= b.z;
-    return a;
-}
-
-vector3 vec3_mul(vector3 vector, float scalar)
-{
-    vector.x *= scalar;
-    vector.y *= scalar;
-    vector.z *= scalar;
-    return vector;
+    return result;
 }
 
 vector3 vec3_mul_mat3x3(vector3 vector, Mtx mat)
 {
-    float fMat[4][4];
-    guMtxL2F(fMat, &mat);
-    vector.x = (vector.x * fMat[0][0]) + (vector.y * fMat[1][0]) + (vector.z * fMat[2][0]);
-    vector.y = (vector.x * fMat[0][1]) + (vector.y * fMat[1][1]) + (vector.z * fMat[2][1]);
-    vector.z = (vector.x * fMat[0][2]) + (vector.y * fMat[1][2]) + (vector.z * fMat[2][2]);
-    return vector;
+    matrix3 rotation = mat3_from_mtx(&mat);
+    return vec3_mul_mat3(vector, &rotation);
 }
 
 vector3 vec3_mul_mat4x4(vector3 vector, Mtx mat)
 {
-    float fMat[4][4];
-    guMtxL2F(fMat, &mat);
     vector = vec3_mul_mat3x3(vector, mat);
-    vector.x += fMat[3][0];
-    vector.y += fMat[3][1];
-    vector.z += fMat[3][2];
+    vector.x += FIXED_TO_SCALAR(mtx_element(&mat, 3, 0));
+    vector.y += FIXED_TO_SCALAR(mtx_element(&mat, 3, 1));
+    vector.z += FIXED_TO_SCALAR(mtx_element(&mat, 3, 2));
     return vector;
-}
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "vecmath.h"
+
+fixed32 fixed_mul(fixed32 a, fixed32 b)
+{
+    return (fixed32)(((long long)a * b) >> 16);
+}
+
+fixed32 fixed_div(fixed32 a, fixed32 b)
+{
+    if (b == 0) return a < 0 ? -0x7FFFFFFF : 0x7FFFFFFF;
+    return (fixed32)(((long long)a << 16) / b);
+}
+
+fixed32 fixed_sqrt(fixed32 value)
+{
+    // Bit by bit integer root of the value scaled up by another 16 bits, which leaves the root in s15.16.
+    unsigned long long remainder = (unsigned long long)value << 16;
+    unsigned long long root = 0;
+    unsigned long long bit = 1ULL << 46;
+
+    if (value <= 0) return 0;
+
+    while (bit > remainder) bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (remainder >= root + bit)
+        {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (fixed32)root;
+}
+
+float vec3f_dot(vec3f a, vec3f b)
+{
+    return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+
+float vec3f_len(vec3f a, vec3f b)
+{
+    return sqrtf(vec3f_dot(a, b));
+}
+
+vec3f vec3f_norm(vec3f vector)
+{
+    const float len = vec3f_len(vector, vector);
+    return (vec3f) { vector.x / len, vector.y / len, vector.z / len };
+}
+
+vec3f vec3f_add(vec3f a, vec3f b)
+{
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+    return a;
+}
+
+vec3f vec3f_sub(vec3f a, vec3f b)
+{
+    a.x -= b.x;
+    a.y -= b.y;
+    a.z -= b.z;
+    return a;
+}
+
+vec3f vec3f_mul(vec3f vector, float scalar)
+{
+    vector.x *= scalar;
+    vector.y *= scalar;
+    vector.z *= scalar;
+    return vector;
+}
+
+vec3f vec3f_mul_mat3(vec3f vector, const mat3f *mat)
+{
+    return (vec3f) {
+        (vector.x * mat->m[0][0]) + (vector.y * mat->m[1][0]) + (vector.z * mat->m[2][0]),
+        (vector.x * mat->m[0][1]) + (vector.y * mat->m[1][1]) + (vector.z * mat->m[2][1]),
+        (vector.x * mat->m[0][2]) + (vector.y * mat->m[1][2]) + (vector.z * mat->m[2][2])
+    };
+}
+
+fixed32 vec3x_dot(vec3x a, vec3x b)
+{
+    // Summed at full width so only the final result has to fit.
+    return (fixed32)(((long long)a.x * b.x + (long long)a.y * b.y + (long long)a.z * b.z) >> 16);
+}
+
+fixed32 vec3x_len(vec3x a, vec3x b)
+{
+    return fixed_sqrt(vec3x_dot(a, b));
+}
+
+vec3x vec3x_norm(vec3x vector)
+{
+    const fixed32 len = vec3x_len(vector, vector);
+    return (vec3x) { fixed_div(vector.x, len), fixed_div(vector.y, len), fixed_div(vector.z, len) };
+}
+
+vec3x vec3x_add(vec3x a, vec3x b)
+{
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+    return a;
+}
+
+vec3x vec3x_sub(vec3x a, vec3x b)
+{
+    a.x -= b.x;
+    a.y -= b.y;
+    a.z -= b.z;
+    return a;
+}
+
+vec3x vec3x_mul(vec3x vector, fixed32 scalar)
+{
+    vector.x = fixed_mul(vector.x, scalar);
+    vector.y = fixed_mul(vector.y, scalar);
+    vector.z = fixed_mul(vector.z, scalar);
+    return vector;
+}
+
+vec3x vec3x_mul_mat3(vec3x vector, const mat3x *mat)
+{
+    vec3x result;
+
+    result.x = (fixed32)(((long long)vector.x * mat->m[0][0] + (long long)vector.y * mat->m[1][0]
+        + (long long)vector.z * mat->m[2][0]) >> 16);
+    result.y = (fixed32)(((long long)vector.x * mat->m[0][1] + (long long)vector.y * mat->m[1][1]
+        + (long long)vector.z * mat->m[2][1]) >> 16);
+    result.z = (fixed32)(((long long)vector.x * mat->m[0][2] + (long long)vector.y * mat->m[1][2]
+        + (long long)vector.z * mat->m[2][2]) >> 16);
+    return result;
+}
@@ -0,0 +1,109 @@
+#ifndef _VECMATH_H_
+#define _VECMATH_H_
+
+#include <math.h>
+
+// Signed s15.16 fixed point, the same split libultra uses for each element of an Mtx.
+// Results past 32767 overflow, so squared lengths only hold for distances up to about 180 units.
+typedef int fixed32;
+
+#define FIXED_ONE 0x10000
+#define FLOAT_TO_FIXED(value) ((fixed32)((value) * 65536.0F))
+#define FIXED_TO_FLOAT(value) ((float)(value) * (1.0F / 65536.0F))
+
+typedef struct vec3f
+{
+    float x, y, z;
+} vec3f;
+
+typedef struct vec3x
+{
+    fixed32 x, y, z;
+} vec3x;
+
+// Rows are where the x, y and z axes end up, matching the upper 3x3 of a gu matrix.
+typedef struct mat3f
+{
+    float m[3][3];
+} mat3f;
+
+typedef struct mat3x
+{
+    fixed32 m[3][3];
+} mat3x;
+
+fixed32 fixed_mul(fixed32 a, fixed32 b);
+
+fixed32 fixed_div(fixed32 a, fixed32 b);
+
+fixed32 fixed_sqrt(fixed32 value);
+
+float vec3f_dot(vec3f a, vec3f b);
+
+float vec3f_len(vec3f a, vec3f b);
+
+vec3f vec3f_norm(vec3f vector);
+
+vec3f vec3f_add(vec3f a, vec3f b);
+
+vec3f vec3f_sub(vec3f a, vec3f b);
+
+vec3f vec3f_mul(vec3f vector, float scalar);
+
+vec3f vec3f_mul_mat3(vec3f vector, const mat3f *mat);
+
+fixed32 vec3x_dot(vec3x a, vec3x b);
+
+fixed32 vec3x_len(vec3x a, vec3x b);
+
+vec3x vec3x_norm(vec3x vector);
+
+vec3x vec3x_add(vec3x a, vec3x b);
+
+vec3x vec3x_sub(vec3x a, vec3x b);
+
+vec3x vec3x_mul(vec3x vector, fixed32 scalar);
+
+vec3x vec3x_mul_mat3(vec3x vector, const mat3x *mat);
+
+// Actor and collision math is written against the names below. Build with -DUER_FIXED_POINT to run it
+// in s15.16 instead of single precision, in which case scripts have to go through SCALAR and scalar_mul too.
+#ifdef UER_FIXED_POINT
+typedef fixed32 scalar;
+typedef vec3x vector3;
+typedef mat3x matrix3;
+#define SCALAR(value) FLOAT_TO_FIXED(value)
+#define SCALAR_TO_FLOAT(value) FIXED_TO_FLOAT(value)
+#define FIXED_TO_SCALAR(value) (value)
+#define scalar_mul fixed_mul
+#define scalar_div fixed_div
+#define scalar_sqrt fixed_sqrt
+#define vec3_dot vec3x_dot
+#define vec3_len vec3x_len
+#define vec3_norm vec3x_norm
+#define vec3_add vec3x_add
+#define vec3_sub vec3x_sub
+#define vec3_mul vec3x_mul
+#define vec3_mul_mat3 vec3x_mul_mat3
+#else
+typedef float scalar;
+typedef vec3f vector3;
+typedef mat3f matrix3;
+#define SCALAR(value) ((float)(value))
+#define SCALAR_TO_FLOAT(value) ((float)(value))
+#define FIXED_TO_SCALAR(value) FIXED_TO_FLOAT(value)
+#define scalar_mul(a, b) ((a) * (b))
+#define scalar_div(a, b) ((a) / (b))
+#define scalar_sqrt sqrtf
+#define vec3_dot vec3f_dot
+#define vec3_len vec3f_len
+#define vec3_norm vec3f_norm
+#define vec3_add vec3f_add
+#define vec3_sub vec3f_sub
+#define vec3_mul vec3f_mul
+#define vec3_mul_mat3 vec3f_mul_mat3
+#endif
+
+#define scalar_abs(value) ((value) < 0 ? -(value) : (value))
+
+#endif
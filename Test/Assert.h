@@ -13,4 +13,14 @@ public:
         ss << "'" << expected << "'" << " does not equal " << "'" << actual << "'";
         if (expected != actual) throw exception(ss.str().c_str());
     }
+
+    void Equal(int expected, int actual)
+    {
+        Equal(to_string(expected), to_string(actual));
+    }
+
+    void True(bool condition, string message)
+    {
+        if (!condition) throw exception(message.c_str());
+    }
 };
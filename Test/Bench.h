@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+class CBench
+{
+public:
+    // Runs the body enough times to get a stable reading and reports the time per operation it performs.
+    void Measure(string context, int operations, function<void()> body)
+    {
+        m_benches.push_back({ context, operations, body });
+    }
+
+    void Run()
+    {
+        const int minRuns = 10;
+        const chrono::milliseconds minTime(200);
+        cout << "Starting benchmarks\n";
+
+        for (const auto &bench : m_benches)
+        {
+            int runs = 0;
+            const auto start = chrono::high_resolution_clock::now();
+            chrono::duration<double, nano> elapsed(0);
+
+            while (runs < minRuns || elapsed < minTime)
+            {
+                bench.body();
+                runs++;
+                elapsed = chrono::high_resolution_clock::now() - start;
+            }
+
+            cout << bench.context << ": " << elapsed.count() / (static_cast<double>(runs) * bench.operations)
+                << " ns\n";
+        }
+
+        cout << "Done!\n";
+    }
+
+private:
+    struct Bench
+    {
+        string context;
+        int operations;
+        function<void()> body;
+    };
+
+    vector<Bench> m_benches;
+};
@@ -0,0 +1,33 @@
+#ifndef _NUSYS_H_
+#define _NUSYS_H_
+
+// Just enough of NuSystem and libultra for the engine's pool and actor headers to build on the host, with
+// each type the size it has on the N64 so the benchmarks walk the same layout.
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef signed char s8;
+typedef short s16;
+typedef int s32;
+typedef float f32;
+
+typedef struct
+{
+    u32 w0, w1;
+} Gfx;
+
+typedef union
+{
+    s32 m[4][4];
+    long long forceAlignment;
+} Mtx;
+
+typedef struct
+{
+    u16 button;
+    s8 stick_x, stick_y;
+    u8 errnum;
+    u16 trigger;
+} NUContData;
+
+#endif
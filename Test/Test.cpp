@@ -1,16 +1,702 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <FastLZ/fastlz.h>
+#include "Bench.h"
 #include "Unit.h"
 #include "../Editor/Util.h"
+#include "../Editor/GbiEncoder.h"
+#include "../Editor/MeshConverter.h"
+#include "../Editor/MeshOptimizer.h"
+#include "../Editor/MeshSimplifier.h"
+#include "../Editor/NameHash.h"
+#include "../Editor/ScriptRewriter.h"
+#include "../Editor/SegmentPacker.h"
+#include "../Editor/TextureConverter.h"
+#include "../Editor/TextureTiler.h"
+
+extern "C" {
+// The engine's vector and transform types would clash with std::vector and std::transform.
+#define vector actorVector
+#define transform actorTransform
+#include "../Engine/pool.h"
+#undef vector
+#undef transform
+#include "../Engine/unpack.h"
+#include "../Engine/vecmath.h"
+}
 
 using namespace UltraEd;
 
-int main()
+// Reproduces how the engine parsed a vertex from the old text mesh format at boot.
+N64Vertex ParseTextVertex(const Vertex &vertex, const D3DXVECTOR3 &scale, const array<int, 2> &textureSize)
+{
+    char line[256];
+    double x, y, z, r, g, b, a, s, t, scaleX, scaleY, scaleZ;
+    D3DXCOLOR color(vertex.color);
+
+    sprintf(line, "%f %f %f %f %f %f %f %f %f", vertex.position.x, vertex.position.y, vertex.position.z,
+        color.r, color.g, color.b, color.a, vertex.tu, vertex.tv);
+    sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf %lf", &x, &y, &z, &r, &g, &b, &a, &s, &t);
+
+    sprintf(line, "%lf %lf %lf", scale.x, scale.y, scale.z);
+    sscanf(line, "%lf %lf %lf", &scaleX, &scaleY, &scaleZ);
+
+    N64Vertex parsed;
+    parsed.ob[0] = static_cast<short>(x * scaleX * 100);
+    parsed.ob[1] = static_cast<short>(y * scaleY * 100);
+    parsed.ob[2] = static_cast<short>(-z * scaleZ * 100);
+    parsed.flag = 0;
+    parsed.tc[0] = static_cast<short>(static_cast<int>(s * textureSize[0]) << 5);
+    parsed.tc[1] = static_cast<short>(static_cast<int>(t * textureSize[1]) << 5);
+    parsed.cn[0] = static_cast<unsigned char>(r * 255);
+    parsed.cn[1] = static_cast<unsigned char>(g * 255);
+    parsed.cn[2] = static_cast<unsigned char>(b * 255);
+    parsed.cn[3] = static_cast<unsigned char>(a * 255);
+    return parsed;
+}
+
+// The double precision vector math the engine ran before vecmath.h, kept as the reference.
+struct DoubleVector
+{
+    double x, y, z;
+};
+
+double Dot(const DoubleVector &a, const DoubleVector &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+DoubleVector Normalize(const DoubleVector &vector)
+{
+    const double length = sqrt(Dot(vector, vector));
+    return { vector.x / length, vector.y / length, vector.z / length };
+}
+
+DoubleVector Rotate(const DoubleVector &vector, const double (&mat)[3][3])
+{
+    return { vector.x * mat[0][0] + vector.y * mat[1][0] + vector.z * mat[2][0],
+        vector.x * mat[0][1] + vector.y * mat[1][1] + vector.z * mat[2][1],
+        vector.x * mat[0][2] + vector.y * mat[1][2] + vector.z * mat[2][2] };
+}
+
+vector<DoubleVector> RandomVectors(int count, double range)
+{
+    mt19937 generator(1234);
+    uniform_real_distribution<double> distribution(-range, range);
+    vector<DoubleVector> vectors;
+
+    for (int i = 0; i < count; i++)
+    {
+        vectors.push_back({ distribution(generator), distribution(generator), distribution(generator) });
+    }
+
+    return vectors;
+}
+
+// Same rows guRotateF produces for an angle in degrees around a unit axis.
+void RotationMatrix(double angle, const DoubleVector &axis, double (&mat)[3][3])
+{
+    const DoubleVector unit = Normalize(axis);
+    const double radians = angle * 3.14159265358979323846 / 180, c = cos(radians), s = sin(radians), t = 1 - c;
+
+    mat[0][0] = t * unit.x * unit.x + c;
+    mat[0][1] = t * unit.x * unit.y + s * unit.z;
+    mat[0][2] = t * unit.x * unit.z - s * unit.y;
+    mat[1][0] = t * unit.x * unit.y - s * unit.z;
+    mat[1][1] = t * unit.y * unit.y + c;
+    mat[1][2] = t * unit.y * unit.z + s * unit.x;
+    mat[2][0] = t * unit.x * unit.z + s * unit.y;
+    mat[2][1] = t * unit.y * unit.z - s * unit.x;
+    mat[2][2] = t * unit.z * unit.z + c;
+}
+
+// An actor as the engine kept it before the pool split it up, rebuilt from the engine's own types so each
+// part is the size it is on the N64.
+struct ActorRecord
+{
+    actor fields;
+    actorModel model;
+    actorTransform matrices;
+    sphereBounds bounds;
+    transformState state;
+};
+
+bool SameVector(const vec3f &a, const vec3f &b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// What drawActors checks for an actor that didn't move before culling it: the pose against what was composed.
+bool Unchanged(const actor &fields, const transformState &state)
+{
+    return !state.dirty && SameVector(fields.position, state.composed.position)
+        && SameVector(fields.scale, state.composed.scale)
+        && SameVector(fields.rotationAxis, state.composed.rotationAxis)
+        && fields.rotationAngle == state.composed.rotationAngle;
+}
+
+bool Culled(const sphereBounds &bounds, const float (&planes)[6][4])
+{
+    for (const auto &plane : planes)
+    {
+        if (bounds.center.x * plane[0] + bounds.center.y * plane[1] + bounds.center.z * plane[2] + plane[3]
+            < -bounds.radius) return true;
+    }
+
+    return false;
+}
+
+bool Near(double expected, double actual, double tolerance)
+{
+    return fabs(expected - actual) <= tolerance;
+}
+
+int main(int argc, char *argv[])
 {
     CUnit testRunner;
+    CBench bench;
+
+    // Benchmarks take a while and only print timings, so they run instead of the tests when asked for.
+    const bool benchmarks = argc > 1 && string(argv[1]) == "--bench";
 
     testRunner.It("creates a new resource name with number", [](CAssert assert) {
-        assert.Equal(CUtil::NewResourceName(26), "UER_26");
+        assert.Equal(Util::NewResourceName(26), "UER_26");
+    });
+
+    testRunner.It("writes binary mesh vertices matching the parsed text format with exact colors", [](CAssert assert) {
+        const array<int, 2> textureSize { 32, 64 };
+        const D3DXVECTOR3 scales[] { D3DXVECTOR3(1, 1, 1), D3DXVECTOR3(2.5f, 0.5f, 1.25f) };
+        const D3DCOLOR colors[] { D3DCOLOR_COLORVALUE(1, 1, 1, 1), D3DCOLOR_COLORVALUE(1, 0, 1, 0),
+            D3DCOLOR_ARGB(200, 2, 127, 254), D3DCOLOR_ARGB(1, 37, 128, 255) };
+
+        for (const auto &scale : scales)
+        {
+            for (const auto &color : colors)
+            {
+                for (int i = -40; i <= 40; i++)
+                {
+                    for (int j = 0; j <= 16; j++)
+                    {
+                        Vertex vertex { D3DXVECTOR3(i * 0.05f, i * 0.125f, i * -0.0375f), D3DXVECTOR3(0, 0, 0),
+                            color, j / 16.0f, 1 - j / 16.0f };
+
+                        RomBuffer buffer;
+                        MeshConverter::Write(buffer, MeshConverter::ToN64(vertex, scale, textureSize));
+
+                        assert.Equal(MeshConverter::VertexSize, static_cast<int>(buffer.Size()));
+
+                        // Positions and texture coordinates round the same as text while colors come
+                        // straight from the packed ARGB, where text truncated channels like 2 down to 1.
+                        N64Vertex expected = ParseTextVertex(vertex, scale, textureSize);
+                        const unsigned char channels[] { static_cast<unsigned char>(color >> 16),
+                            static_cast<unsigned char>(color >> 8), static_cast<unsigned char>(color),
+                            static_cast<unsigned char>(color >> 24) };
+                        memcpy(expected.cn, channels, sizeof(expected.cn));
+
+                        assert.True(MeshConverter::Read(buffer.Data().data()) == expected,
+                            "binary vertex differs from text vertex");
+                    }
+                }
+            }
+        }
+    });
+
+    testRunner.It("keeps vertex colors exact in binary meshes", [](CAssert assert) {
+        Vertex vertex { D3DXVECTOR3(0, 0, 0), D3DXVECTOR3(0, 0, 0), D3DCOLOR_ARGB(200, 2, 127, 254), 0, 0 };
+        const auto n64Vertex = MeshConverter::ToN64(vertex, D3DXVECTOR3(1, 1, 1), { 0, 0 });
+
+        assert.Equal(2, n64Vertex.cn[0]);
+        assert.Equal(127, n64Vertex.cn[1]);
+        assert.Equal(254, n64Vertex.cn[2]);
+        assert.Equal(200, n64Vertex.cn[3]);
+
+        // The text format went through floats and truncated, which lost a step on most channels.
+        const auto textVertex = ParseTextVertex(vertex, D3DXVECTOR3(1, 1, 1), { 0, 0 });
+        assert.Equal(1, textVertex.cn[0]);
+        assert.Equal(126, textVertex.cn[1]);
+        assert.Equal(253, textVertex.cn[2]);
+    });
+
+    testRunner.It("reduces vertex loads for indexed meshes without losing triangles", [](CAssert assert) {
+        // A 16x16 grid of quads with every corner duplicated like the importer produces.
+        vector<N64Vertex> vertices;
+        auto corner = [](int x, int y) { return N64Vertex { { static_cast<short>(x), static_cast<short>(y), 0 }, 0, { 0, 0 }, { 255, 255, 255, 255 } }; };
+        for (int y = 0; y < 16; y++)
+        {
+            for (int x = 0; x < 16; x++)
+            {
+                vertices.insert(vertices.end(), { corner(x, y), corner(x + 1, y), corner(x, y + 1) });
+                vertices.insert(vertices.end(), { corner(x + 1, y), corner(x + 1, y + 1), corner(x, y + 1) });
+            }
+        }
+
+        const auto mesh = MeshOptimizer::Optimize(vertices);
+        const int before = MeshOptimizer::DeindexedVertexLoads(vertices);
+        const int after = MeshOptimizer::VertexLoads(mesh);
+        // Each of the 512 triangles loads its own three corners without indexing.
+        assert.Equal(1536, before);
+        assert.Equal(527, after);
+
+        vector<N64Vertex> triangles;
+        for (const auto &batch : mesh.batches)
+        {
+            assert.True(batch.vertexCount <= MeshOptimizer::VertexCacheSize, "batch overflows the vertex cache");
+
+            for (int i = batch.triangleStart * 3; i < (batch.triangleStart + batch.triangleCount) * 3; i++)
+            {
+                triangles.push_back(mesh.vertices[batch.vertexStart + mesh.indices[i]]);
+            }
+        }
+
+        assert.Equal(static_cast<int>(vertices.size()), static_cast<int>(triangles.size()));
+
+        for (size_t i = 0; i < vertices.size(); i += 3)
+        {
+            auto match = find_if(triangles.begin(), triangles.end(), [&](const N64Vertex &vertex) {
+                const size_t at = &vertex - triangles.data();
+                return at % 3 == 0 && vertex == vertices[i] && triangles[at + 1] == vertices[i + 1] && triangles[at + 2] == vertices[i + 2];
+            });
+            assert.True(match != triangles.end(), "triangle missing after optimization");
+        }
+    });
+
+    testRunner.It("simplifies meshes down to the target triangle count", [](CAssert assert) {
+        vector<N64Vertex> vertices;
+        auto corner = [](int x, int y) { return N64Vertex { { static_cast<short>(x * 10), 0, static_cast<short>(y * 10) }, 0, { 0, 0 }, { 255, 255, 255, 255 } }; };
+        for (int y = 0; y < 16; y++)
+        {
+            for (int x = 0; x < 16; x++)
+            {
+                vertices.insert(vertices.end(), { corner(x, y), corner(x, y + 1), corner(x + 1, y) });
+                vertices.insert(vertices.end(), { corner(x + 1, y), corner(x, y + 1), corner(x + 1, y + 1) });
+            }
+        }
+
+        const auto simplified = MeshSimplifier::Simplify(vertices, 128);
+        const int triangles = static_cast<int>(simplified.size() / 3);
+        assert.Equal(512, static_cast<int>(vertices.size() / 3));
+        assert.Equal(128, triangles);
+
+        // A flat grid can lose its interior without changing shape, so the corners must survive.
+        for (const auto &expected : { corner(0, 0), corner(16, 0), corner(0, 16), corner(16, 16) })
+        {
+            auto match = find_if(simplified.begin(), simplified.end(), [&](const N64Vertex &vertex) {
+                return memcmp(vertex.ob, expected.ob, sizeof(vertex.ob)) == 0;
+            });
+            assert.True(match != simplified.end(), "grid corner was collapsed");
+        }
+    });
+
+    testRunner.It("encodes display list commands the same as the gbi.h macros", [](CAssert assert) {
+        GbiEncoder encoder;
+        encoder.SetRenderMode(GbiEncoder::RenderModeOpaque, GbiEncoder::RenderModeOpaque2);
+        encoder.SetCombine(GbiEncoder::CombineShade, GbiEncoder::CombineShade);
+        encoder.SetCombine(GbiEncoder::CombineModulateRgb, GbiEncoder::CombineModulateRgb);
+        encoder.GeometryMode(0xFFFFFFFF, GbiEncoder::Shade | GbiEncoder::ZBuffer);
+        encoder.Vertex(1, 0x10, 32, 0);
+        encoder.Triangles(0, 1, 2, 3, 4, 5);
+        encoder.EndDisplayList();
+
+        RomBuffer buffer;
+        vector<unsigned int> relocations;
+        encoder.Write(buffer, &relocations);
+
+        const unsigned int expected[] {
+            0xE200001C, 0x00552078, 0xFCFFFFFF, 0xFFFE793C, 0xFC127E24, 0xFFFFF9FC, 0xD9000000, 0x00000005,
+            0x01020040, 0x01000010, 0x06000204, 0x0006080A, 0xDF000000, 0x00000000
+        };
+
+        assert.Equal(static_cast<int>(sizeof(expected)), static_cast<int>(buffer.Size()));
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+        {
+            assert.True(RomBuffer::Read32(&buffer.Data()[i * 4]) == expected[i], "command word differs from gbi.h");
+        }
+
+        assert.Equal(1, static_cast<int>(relocations.size()));
+        assert.Equal(36, static_cast<int>(relocations[0]));
+    });
+
+    testRunner.It("loads palettes the same as the gbi.h TLUT macros", [](CAssert assert) {
+        GbiEncoder encoder;
+        encoder.LoadTlut(2, 0, 16);
+
+        RomBuffer buffer;
+        encoder.Write(buffer, nullptr);
+
+        // gDPLoadTLUT_pal16 for palette 0 at the start of segment 2.
+        const unsigned int expected[] {
+            0xFD100000, 0x02000000, 0xE8000000, 0x00000000, 0xF5000100, 0x07000000, 0xE6000000, 0x00000000,
+            0xF0000000, 0x0703C000, 0xE7000000, 0x00000000
+        };
+
+        assert.Equal(static_cast<int>(sizeof(expected)), static_cast<int>(buffer.Size()));
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+        {
+            assert.True(RomBuffer::Read32(&buffer.Data()[i * 4]) == expected[i], "command word differs from gbi.h");
+        }
+    });
+
+    testRunner.It("writes palettized textures only when no color is lost", [](CAssert assert) {
+        auto gradient = [](int width, int height, int levels) {
+            vector<unsigned char> pixels;
+            for (int y = 0; y < height; y++)
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    pixels.insert(pixels.end(), { static_cast<unsigned char>(x * levels / width * 256 / levels),
+                        static_cast<unsigned char>(y * levels / height * 256 / levels), 64, 255 });
+                }
+            }
+            return pixels;
+        };
+
+        const auto few = gradient(32, 32, 3), many = gradient(32, 32, 32), large = gradient(64, 64, 32);
+        const auto largeFew = gradient(64, 64, 8);
+        assert.True(TextureConverter::ChooseFormat(few.data(), 32, 32) == TexelFormat::Ci4, "9 colors aren't CI4");
+        assert.True(TextureConverter::ChooseFormat(many.data(), 32, 32) == TexelFormat::Rgba16, "RGBA16 was reduced");
+        assert.True(TextureConverter::ChooseFormat(large.data(), 64, 64) == TexelFormat::Rgba16,
+            "large RGBA16 was reduced");
+        assert.True(TextureConverter::ChooseFormat(largeFew.data(), 64, 64) == TexelFormat::Ci8,
+            "64 colors aren't CI8");
+
+        RomBuffer buffer;
+        TextureConverter::Write(buffer, TexelFormat::Ci4, few.data(), 32, 32);
+        assert.Equal(16 * 2 + 32 * 32 / 2, static_cast<int>(buffer.Size()));
+
+        for (int i = 0; i < 32 * 32; i++)
+        {
+            const int index = (buffer.Data()[32 + i / 2] >> (i % 2 ? 0 : 4)) & 15;
+            const unsigned short color = RomBuffer::Read16(&buffer.Data()[index * 2]);
+            assert.True(color == TextureConverter::ToRgba5551(&few[i * 4]), "lossless palette changed a color");
+        }
+
+        vector<unsigned short> texels;
+        vector<unsigned char> indices;
+        for (int i = 0; i < 64 * 64; i++) texels.push_back(TextureConverter::ToRgba5551(&large[i * 4]));
+
+        const auto palette = TextureConverter::Quantize(texels, 16, indices);
+        assert.Equal(16, static_cast<int>(palette.size()));
+
+        for (size_t i = 0; i < texels.size(); i++)
+        {
+            const unsigned short a = texels[i], b = palette[indices[i]];
+            for (int shift = 1; shift < 16; shift += 5)
+            {
+                assert.True(abs(((a >> shift) & 31) - ((b >> shift) & 31)) <= 4, "quantized color too far off");
+            }
+        }
+    });
+
+    testRunner.It("cuts meshes with large textures along the tiles they load", [](CAssert assert) {
+        const auto layout = TextureTiler::Layout({ 128, 128 }, TexelFormat::Rgba16);
+        assert.True(layout.IsTiled(), "texture wasn't tiled");
+        assert.Equal(64, layout.tileSize[0]);
+        assert.Equal(32, layout.tileSize[1]);
+
+        // A quad mapped across the whole texture, with s10.5 coordinates as MeshConverter writes them.
+        auto corner = [](short x, short y) { return N64Vertex { { x, y, 0 }, 0, { short(x * 32), short(y * 32) },
+            { 255, 255, 255, 255 } }; };
+        const vector<N64Vertex> quad { corner(0, 0), corner(128, 0), corner(128, 128),
+            corner(0, 0), corner(128, 128), corner(0, 128) };
+
+        const auto groups = TextureTiler::Split(quad, layout);
+        assert.Equal(layout.TileCount(), static_cast<int>(groups.size()));
+
+        double area = 0;
+        for (const auto &group : groups)
+        {
+            const int originX = group.first % 2 * 64, originY = group.first / 2 * 32;
+            for (size_t i = 0; i < group.second.size(); i += 3)
+            {
+                const N64Vertex *v = &group.second[i];
+                area += fabs((v[1].ob[0] - v[0].ob[0]) * (v[2].ob[1] - v[0].ob[1])
+                    - (v[2].ob[0] - v[0].ob[0]) * (v[1].ob[1] - v[0].ob[1])) / 2;
+
+                for (int j = 0; j < 3; j++)
+                {
+                    assert.True(v[j].tc[0] >= 0 && v[j].tc[0] <= 64 * 32 && v[j].tc[1] >= 0 && v[j].tc[1] <= 32 * 32,
+                        "coordinates leave the tile");
+                    assert.True(v[j].ob[0] - originX == v[j].tc[0] / 32 && v[j].ob[1] - originY == v[j].tc[1] / 32,
+                        "coordinates no longer match the position");
+                }
+            }
+        }
+        assert.True(Near(128.0 * 128.0, area, 1e-6), "cut triangles don't cover the quad");
+
+        vector<unsigned char> pixels(128 * 128 * 4);
+        pixels[(40 * 128 + 70) * 4] = 1;
+        const auto tiled = TextureTiler::TilePixels(pixels.data(), layout);
+        assert.Equal(1, static_cast<int>(tiled[(3 * 64 * 32 + 8 * 64 + 6) * 4]));
+    });
+
+    testRunner.It("unpacks compressed segments to the same bytes in the engine", [](CAssert assert) {
+        // Rows repeat every 16 KB so level 2 has matches further back than level 1 can reach.
+        mt19937 random(5);
+        vector<unsigned char> row(16384);
+        for (auto &value : row) value = static_cast<unsigned char>(random() % 4);
+
+        vector<unsigned char> data;
+        for (int i = 0; i < 6; i++)
+        {
+            data.insert(data.end(), row.begin(), row.end());
+            data.insert(data.end(), i * 100, static_cast<unsigned char>(i));
+        }
+
+        for (int level = 1; level <= 2; level++)
+        {
+            vector<unsigned char> compressed(data.size() * 2), unpacked(data.size());
+            const int size = fastlz_compress_level(level, data.data(), static_cast<int>(data.size()),
+                compressed.data());
+            assert.Equal(static_cast<int>(data.size()), unpackBlock(compressed.data(), size, unpacked.data(),
+                static_cast<int>(unpacked.size())));
+            assert.True(unpacked == data, "unpacked bytes differ");
+            assert.Equal(0, unpackBlock(compressed.data(), size, unpacked.data(), static_cast<int>(data.size()) - 1));
+        }
+
+        RomBuffer segment;
+        segment.Write(data.data(), data.size());
+        const auto packed = SegmentPacker::Pack(segment);
+        const int packedSize = static_cast<int>(RomBuffer::Read32(&packed.Data()[4]));
+        assert.True(SegmentPacker::IsPacked(packed), "compressible segment was stored");
+        assert.Equal(static_cast<int>(data.size()), static_cast<int>(RomBuffer::Read32(&packed.Data()[0])));
+        assert.Equal(packedSize, static_cast<int>(packed.Size()) - SegmentPacker::HeaderSize);
+
+        vector<unsigned char> unpacked(data.size());
+        unpackBlock(&packed.Data()[SegmentPacker::HeaderSize], packedSize, unpacked.data(),
+            static_cast<int>(data.size()));
+        assert.True(unpacked == data, "unpacked segment differs");
+
+        RomBuffer noise;
+        for (int i = 0; i < 1000; i++) noise.Write8(static_cast<unsigned char>(random()));
+        assert.True(!SegmentPacker::IsPacked(SegmentPacker::Pack(noise)), "incompressible segment was packed");
     });
 
+    testRunner.It("places every actor name in its own name table slot", [](CAssert assert) {
+        vector<string> names { "Camera", "Player", "Cube", "" };
+        for (int i = 0; i < 500; i++)
+        {
+            names.push_back(Util::NewResourceName(i));
+        }
+
+        const NameTable table = NameHash::Build(names);
+        assert.True(table.slots.size() < names.size() * 2, "name table is too sparse");
+
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            assert.Equal(static_cast<int>(i), NameHash::Find(table, names, names[i]));
+        }
+
+        assert.Equal(-1, NameHash::Find(table, names, "Missing"));
+    });
+
+    testRunner.It("passes self to the functions of shared scripts", [](CAssert assert) {
+        const string script = "void $start()\r\n{\r\n    $move(1.0F);  \r\n}\r\n\r\n"
+            "static void $move(float speed)\n{\n    self->position.x += speed;\n}\n\n"
+            "void $update(void)\n{\n    if ($ready()) return $move(2.0F);\n}\n\n"
+            "int *$ready()\n{\n    return 0;\n}\n\n";
+
+        assert.Equal(string("void $start()\n{\n}"), ScriptRewriter::Normalize("void $start()  \r\n{\r\n}\r\n\r\n"));
+        assert.Equal(string("void UER_0start(actor *self)\r\n{\r\n    UER_0move(self, 1.0F);  \r\n}\r\n\r\n"
+            "static void UER_0move(actor *self, float speed)\n{\n    self->position.x += speed;\n}\n\n"
+            "void UER_0update(actor *self)\n{\n    if (UER_0ready(self)) return UER_0move(self, 2.0F);\n}\n\n"
+            "int *UER_0ready(actor *self)\n{\n    return 0;\n}\n\n"), ScriptRewriter::Share(script, "UER_0"));
+
+        assert.True(!ScriptRewriter::HasState(script), "script has no state");
+        assert.True(ScriptRewriter::HasState("int $count;\n\nvoid $update()\n{\n    $count++;\n}"), "script has state");
+    });
+
+    testRunner.It("tells pointer return types apart from multiplied calls", [](CAssert assert) {
+        const string script = "#include <math.h>\nstatic const float *$speeds()\n{\n    return 0;\n}\n\n"
+            "float $scale()\n{\n    return 2.0F;\n}\n\n"
+            "void $update()\n{\n    float speed = 1.0F;\n    self->position.x += speed * $scale();\n"
+            "    self->position.y += speed*$scale() * *$speeds();\n}";
+
+        assert.Equal(string("#include <math.h>\nstatic const float *UER_0speeds(actor *self)\n{\n    return 0;\n}\n\n"
+            "float UER_0scale(actor *self)\n{\n    return 2.0F;\n}\n\n"
+            "void UER_0update(actor *self)\n{\n    float speed = 1.0F;\n"
+            "    self->position.x += speed * UER_0scale(self);\n"
+            "    self->position.y += speed*UER_0scale(self) * *UER_0speeds(self);\n}"),
+            ScriptRewriter::Share(script, "UER_0"));
+    });
+
+    testRunner.It("passes self through helpers that call script functions", [](CAssert assert) {
+        const string script = "static void push(float amount);\n\n"
+            "static void push(float amount)\n{\n    $move(amount); // $move(amount)\n}\n\n"
+            "static float half(float amount)\n{\n    return amount / 2.0F;\n}\n\n"
+            "void $update()\n{\n    push(half(1.0F));\n    debug(\"$move(1)\");\n}";
+
+        assert.Equal(string("static void push(actor *self, float amount);\n\n"
+            "static void push(actor *self, float amount)\n{\n    UER_0move(self, amount); // UER_0move(amount)\n}\n\n"
+            "static float half(float amount)\n{\n    return amount / 2.0F;\n}\n\n"
+            "void UER_0update(actor *self)\n{\n    push(self, half(1.0F));\n    debug(\"UER_0move(1)\");\n}"),
+            ScriptRewriter::Share(script, "UER_0"));
+    });
+
+    testRunner.It("gives actors their own copy of scripts with static locals", [](CAssert assert) {
+        const string counter = "void $update()\n{\n    static int timer;\n    timer++;\n}";
+        const string mover = "void $update()\n{\n    self->position.x += 1.0F; // static\n}";
+        const vector<string> prefixes = ScriptRewriter::Prefixes({ counter, counter, mover, mover });
+
+        assert.Equal(string("UER_0"), prefixes[0]);
+        assert.Equal(string("UER_1"), prefixes[1]);
+        assert.Equal(string("UER_2"), prefixes[2]);
+        assert.Equal(string("UER_2"), prefixes[3]);
+    });
+
+    testRunner.It("leaves out script callbacks with nothing in them", [](CAssert assert) {
+        const string script = "void $start()\n{\n\n}\n\nvoid $update()\n{\n    // Nothing yet { }\n"
+            "    /* later */\n}\n\n"
+            "void $input(NUContData gamepads[4])\n{\n    $update();\n}\n\nvoid $collide(actor *other);\n\n"
+            "void $inputs()\n{\n    return;\n}";
+
+        assert.True(!ScriptRewriter::Defines(script, "$start"), "start is empty");
+        assert.True(!ScriptRewriter::Defines(script, "$update"), "update only has comments");
+        assert.True(ScriptRewriter::Defines(script, "$input"), "input has a call");
+        assert.True(!ScriptRewriter::Defines(script, "$collide"), "collide is only declared");
+    });
+
+    testRunner.It("matches double precision vector math in single precision", [](CAssert assert) {
+        const auto vectors = RandomVectors(1000, 100);
+        double mat[3][3];
+        mat3f rotation;
+        RotationMatrix(37, { 1, 2, 3 }, mat);
+        for (int i = 0; i < 9; i++) rotation.m[i / 3][i % 3] = static_cast<float>(mat[i / 3][i % 3]);
+
+        for (size_t i = 0; i + 1 < vectors.size(); i++)
+        {
+            const auto &a = vectors[i], &b = vectors[i + 1];
+            const vec3f fa { float(a.x), float(a.y), float(a.z) }, fb { float(b.x), float(b.y), float(b.z) };
+            const DoubleVector norm = Normalize(a), rotated = Rotate(a, mat);
+            const vec3f fNorm = vec3f_norm(fa), fRotated = vec3f_mul_mat3(fa, &rotation);
+
+            assert.True(Near(Dot(a, b), vec3f_dot(fa, fb), 1e-5 * sqrt(Dot(a, a) * Dot(b, b)) + 1e-3), "dot differs");
+            assert.True(Near(sqrt(Dot(a, a)), vec3f_len(fa, fa), 1e-3), "length differs");
+            assert.True(Near(norm.x, fNorm.x, 1e-6) && Near(norm.y, fNorm.y, 1e-6) && Near(norm.z, fNorm.z, 1e-6),
+                "normal differs");
+            assert.True(Near(rotated.x, fRotated.x, 1e-3) && Near(rotated.y, fRotated.y, 1e-3)
+                && Near(rotated.z, fRotated.z, 1e-3), "rotation differs");
+        }
+    });
+
+    testRunner.It("matches double precision vector math in s15.16 fixed point", [](CAssert assert) {
+        // Kept inside the range where squared lengths still fit in s15.16.
+        const auto vectors = RandomVectors(1000, 10);
+        double mat[3][3];
+        mat3x rotation;
+        RotationMatrix(37, { 1, 2, 3 }, mat);
+        for (int i = 0; i < 9; i++) rotation.m[i / 3][i % 3] = FLOAT_TO_FIXED(mat[i / 3][i % 3]);
+
+        auto toFixed = [](const DoubleVector &v) { return vec3x { FLOAT_TO_FIXED(v.x), FLOAT_TO_FIXED(v.y), FLOAT_TO_FIXED(v.z) }; };
+        auto toDouble = [](fixed32 value) { return static_cast<double>(FIXED_TO_FLOAT(value)); };
+
+        for (size_t i = 0; i + 1 < vectors.size(); i++)
+        {
+            const auto &a = vectors[i], &b = vectors[i + 1];
+            const vec3x xa = toFixed(a), xb = toFixed(b);
+            const DoubleVector norm = Normalize(a), rotated = Rotate(a, mat);
+            const vec3x xNorm = vec3x_norm(xa), xRotated = vec3x_mul_mat3(xa, &rotation);
+
+            assert.True(Near(Dot(a, b), toDouble(vec3x_dot(xa, xb)), 1e-3), "dot differs");
+            assert.True(Near(sqrt(Dot(a, a)), toDouble(vec3x_len(xa, xa)), 1e-3), "length differs");
+            assert.True(Near(norm.x, toDouble(xNorm.x), 1e-3) && Near(norm.y, toDouble(xNorm.y), 1e-3)
+                && Near(norm.z, toDouble(xNorm.z), 1e-3), "normal differs");
+            assert.True(Near(rotated.x, toDouble(xRotated.x), 1e-3) && Near(rotated.y, toDouble(xRotated.y), 1e-3)
+                && Near(rotated.z, toDouble(xRotated.z), 1e-3), "rotation differs");
+            assert.True(Near(a.x * b.y, toDouble(fixed_mul(xa.x, xb.y)), 1e-3), "product differs");
+        }
+    });
+
+    if (benchmarks)
+    {
+        const auto vectors = RandomVectors(1024, 10);
+        const int count = static_cast<int>(vectors.size());
+        double mat[3][3];
+        RotationMatrix(37, { 1, 2, 3 }, mat);
+
+        mat3f floatRotation;
+        mat3x fixedRotation;
+        vector<vec3f> floatVectors;
+        vector<vec3x> fixedVectors;
+        for (int i = 0; i < 9; i++)
+        {
+            floatRotation.m[i / 3][i % 3] = static_cast<float>(mat[i / 3][i % 3]);
+            fixedRotation.m[i / 3][i % 3] = FLOAT_TO_FIXED(mat[i / 3][i % 3]);
+        }
+        for (const auto &v : vectors)
+        {
+            floatVectors.push_back({ float(v.x), float(v.y), float(v.z) });
+            fixedVectors.push_back({ FLOAT_TO_FIXED(v.x), FLOAT_TO_FIXED(v.y), FLOAT_TO_FIXED(v.z) });
+        }
+
+        // Normalize, rotate and dot against the next vector, like a collision axis test.
+        bench.Measure("double normalize, rotate and dot", count, [&]() {
+            volatile double sink = 0;
+            for (int i = 0; i + 1 < count; i++) sink = sink + Dot(Rotate(Normalize(vectors[i]), mat), vectors[i + 1]);
+        });
+
+        bench.Measure("float normalize, rotate and dot", count, [&]() {
+            volatile float sink = 0;
+            for (int i = 0; i + 1 < count; i++)
+                sink = sink + vec3f_dot(vec3f_mul_mat3(vec3f_norm(floatVectors[i]), &floatRotation), floatVectors[i + 1]);
+        });
+
+        bench.Measure("fixed normalize, rotate and dot", count, [&]() {
+            volatile fixed32 sink = 0;
+            for (int i = 0; i + 1 < count; i++)
+                sink = sink + vec3x_dot(vec3x_mul_mat3(vec3x_norm(fixedVectors[i]), &fixedRotation), fixedVectors[i + 1]);
+        });
+
+        const auto positions = RandomVectors(ACTOR_POOL_CAPACITY, 100);
+        const float planes[6][4] { { 1, 0, 0, 60 }, { -1, 0, 0, 60 }, { 0, 1, 0, 60 }, { 0, -1, 0, 60 },
+            { 0, 0, 1, 0 }, { 0, 0, -1, 200 } };
+
+        // Old records were each allocated on their own between the segments the loader read in.
+        vector<unique_ptr<ActorRecord>> records;
+        vector<vector<char>> segments;
+
+        for (int i = 0; i < ACTOR_POOL_CAPACITY; i++)
+        {
+            actor *pooled = allocActor(0);
+            const vec3f position { float(positions[i].x), float(positions[i].y), float(positions[i].z) };
+            const transformState state { { position, { 0, 0, 1 }, { 0.01f, 0.01f, 0.01f }, 0 } };
+
+            *pooled = actor { Model, None, 1, position, { 0, 0, 1 }, 0, { 0.01f, 0.01f, 0.01f } };
+            actorStates[i] = state;
+            actorBounds[i] = { position, 2 };
+
+            records.emplace_back(new ActorRecord());
+            segments.emplace_back(4096);
+            records.back()->fields = *pooled;
+            records.back()->state = state;
+            records.back()->bounds = actorBounds[i];
+        }
+
+        bench.Measure("actors updated and culled through the old actor record", ACTOR_POOL_CAPACITY, [&]() {
+            volatile int drawn = 0;
+            for (const auto &record : records)
+            {
+                if (Unchanged(record->fields, record->state) && record->fields.visible
+                    && !Culled(record->bounds, planes)) drawn = drawn + 1;
+            }
+        });
+
+        bench.Measure("actors updated and culled through the pool's arrays", ACTOR_POOL_CAPACITY, [&]() {
+            volatile int drawn = 0;
+            for (int i = 0; i < ACTOR_POOL_CAPACITY; i++)
+            {
+                if (Unchanged(actorSlots[i], actorStates[i]) && actorSlots[i].visible
+                    && !Culled(actorBounds[i], planes)) drawn = drawn + 1;
+            }
+        });
+
+        bench.Run();
+        return 0;
+    }
+
     testRunner.Run();
 
     return 0;